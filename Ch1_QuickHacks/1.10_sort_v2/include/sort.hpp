@@ -1,234 +1,199 @@
-#ifndef sort_HEADER_INCLUDED_HPP_
-#define sort_HEADER_INCLUDED_HPP_
+#ifndef SORT_V2_SORT_INCLUDED_HPP_
+#define SORT_V2_SORT_INCLUDED_HPP_
 
-#include <istream>
-#include <fstream>
+#include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <list>
+#include <optional>
+#include <functional>
 #include <algorithm>
-#include <iterator>
 #include <utility>
 #include <stdexcept>
-#include <type_traits>
-#include <gsl/gsl>
-
+#include <cstdint>
+#include <cstddef>
+
+#include "jam/jam.hpp"
+#include "jam/line_buffer.hpp"
+#include "jam/line_writer.hpp"
+#include "jam/key_field.hpp"
+#include "jam/mapped_lines.hpp"
+
+
+struct commandline_args
+{
+    bool ignore_case{false};
+    bool reverse_order{false};
+    bool ignore_leading_blanks{false};
+    bool dictionary_order{false};
+    bool random_sort{false};
+    bool check{false};
+    bool merge{false};
+    std::string random_seed{};
+    std::string key{};
+    std::string separator{};
+    std::string buffer_size{};
+    std::vector<std::string> infiles{};
+    std::string outfile{};
+    bool help_flag{false};
+};
 
-namespace jam
-{
 
+using Lines = jam::LineBuffer;
+using Views = std::vector<std::string_view>;
+using Sorter = std::function<void(Views&)>;
+using Predicate = std::function<bool(std::string_view, std::string_view)>;
 
-/* Reading a stream line by line */
-/* ------------------------------------------------------------------------- */
-template<typename Container>
-auto get_lines( std::istream& is ) -> Container
-    // requires push_back()
+// One input, sorted on its own. A mapped file is sorted as views into the
+// mapping; only the lines of inputs that cannot be mapped are copied, into
+// the buffer. Either way the views are valid as long as the run lives.
+struct Run
 {
-    auto lines = Container{};
-    for( std::string line; getline(is, line); ){
-        lines.emplace_back(std::move(line));
-    }
-    return lines;
-}
+    std::optional<jam::MappedLines> mapped{};
+    Lines buffered{};
+    Views lines{};
+};
 
-template<typename Container>
-void get_lines( std::istream& is, Container& container )
+// Hands out the lines of a sorted run one at a time, same as jam::LineReader
+class RunCursor
 {
-    for( std::string line; getline(is, line); ){
-        container.emplace_back( std::move(line) );
+public:
+    explicit RunCursor( const Run& run )
+        : RunCursor{run.lines}
+        { }
+    explicit RunCursor( const Views& lines )
+        : m_current{lines.begin()}, m_end{lines.end()}
+        { }
+    auto next( std::string_view& line ) -> bool
+    {
+        if( m_current == m_end )
+            return false;
+        line = *m_current++;
+        return true;
     }
-}
-
-// --- Filter based on Predicate
+private:
+    Views::const_iterator m_current;
+    Views::const_iterator m_end;
+};
 
-template<typename Container, typename Predicate>
-auto get_lines( std::istream& is, Predicate predicate ) -> Container
-{
-    auto lines = Container{};
-    for( std::string line; getline(is, line); ){
-        if( predicate(line) ){
-            lines.emplace_back( std::move(line) );
-        }
-    }
-    return lines;
-}
 
-template<typename Container, typename Predicate>
-void get_lines( std::istream& is, Container& container, Predicate predicate )
+// Calls visitor with the concrete predicate selected by the command line,
+// so that the wrapped transforms are still visible to the callee.
+// The -f, -d and -b transforms are character-level ones - libjam fuses them
+// into a single pass over each key. The last one wrapped is the first one
+// applied, so -k selects the key before anything else looks at it.
+template<typename Visitor>
+auto visit_predicate( const commandline_args& args, Visitor visitor )
 {
-    for( std::string line; getline(is, line); ){
-        if( predicate(line) ){
-            container.emplace_back( std::move(line) );
-        }
+    auto separator = std::optional<char>{};
+    if( !args.separator.empty() ){
+        if( args.separator.size() != 1 )
+            throw std::invalid_argument( "The field separator must be a single character" );
+        separator = args.separator.front();
     }
+    auto with_key = [&]( auto predicate ){
+        if( !args.key.empty() )
+            return visitor( jam::wrap_binary_predicate( std::move(predicate),
+                                                        jam::KeyField{args.key, separator} ) );
+        return visitor( std::move(predicate) );
+    };
+    auto with_blanks = [&]( auto predicate ){
+        if( args.ignore_leading_blanks )
+            return with_key( jam::wrap_binary_predicate( std::move(predicate), jam::skip_leading_blanks ) );
+        return with_key( std::move(predicate) );
+    };
+    auto with_dictionary = [&]( auto predicate ){
+        if( args.dictionary_order )
+            return with_blanks( jam::wrap_binary_predicate( std::move(predicate), jam::dictionary_order ) );
+        return with_blanks( std::move(predicate) );
+    };
+    auto with_case = [&]( auto predicate ){
+        if( args.ignore_case )
+            return with_dictionary( jam::wrap_binary_predicate( std::move(predicate), jam::fold_case ) );
+        return with_dictionary( std::move(predicate) );
+    };
+
+    if( args.reverse_order )
+        return with_case( std::greater<std::string_view>() );
+    return with_case( std::less<std::string_view>() );
 }
-/* ------------------------------------------------------------------------- */
 
-/* Sorting */
-/* ------------------------------------------------------------------------- */
-template<typename Container, typename Predicate>
-void sort_lines(Container& lines, Predicate pred)
-{
-    std::sort(lines.begin(), lines.end(), pred);
-}
+auto get_predicate( const commandline_args& args ) -> Predicate;
 
-template<typename T, typename Predicate>
-void sort_lines( std::list<T>& lines, Predicate pred )
-{
-    lines.sort(pred);
-}
+auto get_sorter( const commandline_args& args ) -> Sorter;
 
+auto process_file( const std::string& fname, const Sorter& sorter ) -> Run;
 
-/* Composible predicates */
-/* ------------------------------------------------------------------------- */
-template<typename Derived>
-class PredicateBase
-{
-public:
-    Derived* underlying() { return static_cast<Derived*>(this); }
-    const Derived* underlying() const { return static_cast<const Derived*>(this); }
-    
-    template<typename T>
-    auto operator()( T&& t ) -> bool
-    {
-        return underlying()->operator()(std::forward<T>(t));
-    }
+auto process_stream( std::istream& is, const Sorter& sorter ) -> Run;
 
-    template<typename T>
-    auto operator()( T&& t ) const -> bool
-    {
-        return underlying()->operator()(std::forward<T>(t));
-    }
+auto process_files( const std::vector<std::string>& files, const Sorter& sorter,
+                    const Predicate& predicate, const std::string& outfile ) -> void;
 
-    template<typename T>
-    auto operator()( T&& lhs, T&& rhs ) -> bool
-    {
-        return underlying()->operator()( std::forward<T>(lhs), std::forward<T>(rhs) );
-    }
+auto merge_files( const commandline_args& args ) -> void;
 
-    template<typename T>
-    auto operator()( T&& lhs, T&& rhs ) const -> bool
-    {
-        return underlying()->operator()( std::forward<T>(lhs), std::forward<T>(rhs) );
-    }
-private:
-    PredicateBase() noexcept = default;
-    friend Derived;
-};
-
-
-template<typename Predicate, typename Function>
-class PredicateWrapper : public PredicateBase<PredicateWrapper<Predicate,Function>>
-{
-public:
-    constexpr PredicateWrapper( Predicate&& predicate, Function&& function )
-        : m_predicate(std::forward<Predicate>(predicate))
-        , m_function(std::forward<Function>(function))
-        { }
-        
-        template<typename T>
-        auto operator()( T&& t ) -> bool
-        {
-            return m_predicate( m_function(std::forward<T>(t)) );
-        }
-private:
-    Predicate m_predicate;
-    Function m_function;
-};
-
-template<typename Predicate, typename Function>
-auto wrap_predicate( Predicate&& predicate, Function function )
+template<typename Container>
+void write_lines( const std::string& fname, const Container& lines )
 {
-    return PredicateWrapper<Predicate,Function>
-                            (std::forward<Predicate>(predicate),
-                             std::forward<Function>(function)
-                            );
+    auto writer = jam::LineWriter{fname};
+    writer.write_lines(lines);
+    writer.flush();
 }
 
-template<typename Predicate, typename Function, typename... Functions>
-auto wrap_predicate( Predicate&& predicate, Function&& function, Functions&&... functions )
+// k-way merge of sorted sources with a min-heap holding the current line of
+// every source. Each line is written as soon as it is the smallest one left.
+// A source is anything with next(std::string_view&) -> bool.
+template<typename Source>
+void write_lines( const std::string& fname, std::vector<Source>& sources,
+                  const Predicate& predicate )
 {
-    return wrap_predicate(
-            PredicateWrapper<Predicate,Function>(
-                 std::forward<Predicate>(predicate)
-                ,std::forward<Function>(function))
-            ,std::forward<Functions>(functions)...
-            );
+    struct Head
+    {
+        std::string_view line;
+        std::size_t source;
+    };
+    // std::*_heap keep the largest element at the front - flip the order
+    auto heap_compare = [&predicate]( const Head& lhs, const Head& rhs ){
+        return predicate(rhs.line, lhs.line);
+    };
+    auto heap = std::vector<Head>{};
+    heap.reserve(sources.size());
+    for( std::size_t i = 0; i != sources.size(); ++i ){
+        auto head = Head{ {}, i };
+        if( sources[i].next(head.line) )
+            heap.push_back(head);
+    }
+    std::make_heap(heap.begin(), heap.end(), heap_compare);
+
+    auto writer = jam::LineWriter{fname};
+    while( !heap.empty() ){
+        std::pop_heap(heap.begin(), heap.end(), heap_compare);
+        auto& head = heap.back();
+        writer.write_line(head.line);
+        if( sources[head.source].next(head.line) )
+            std::push_heap(heap.begin(), heap.end(), heap_compare);
+        else
+            heap.pop_back();
+    }
+    writer.flush();
 }
 
-template<typename WPred, typename WFunc, typename Function>
-auto operator&&( PredicateWrapper<WPred,WFunc>&& predicate,
-                 Function function )
-{
-    return PredicateWrapper<PredicateWrapper<WPred,WFunc>,Function>
-                            (std::forward<PredicateWrapper<WPred,WFunc>>(predicate)
-                            ,std::forward<Function>(function)
-                            );
-}
 
+// -c: whether the input is sorted, reporting the first line out of order to
+// diagnostics. Throws std::invalid_argument for more than one input.
+auto check_sorted( const commandline_args& args, std::ostream& diagnostics = std::cerr ) -> bool;
 
-// --- Binary Predicates
-template<typename Predicate, typename Function>
-class BinaryPredicateWrapper : public PredicateBase<BinaryPredicateWrapper<Predicate,Function>>
+struct HashedLine
 {
-public:
-    constexpr BinaryPredicateWrapper( Predicate&& predicate, Function&& function )
-        : m_predicate(std::forward<Predicate>(predicate))
-        , m_function(std::forward<Function>(function))
-        { }
-        
-        template<typename T>
-        auto operator()( T&& lhs, T&& rhs ) -> bool
-        {
-            return m_predicate( m_function(std::forward<T>(lhs)),
-                                m_function(std::forward<T>(rhs))
-                              );
-        }
-private:
-    Predicate m_predicate;
-    Function m_function;
+    std::uint64_t hash;
+    std::size_t index;
 };
 
-template<typename Predicate, typename Function>
-auto wrap_binary_predicate( Predicate&& predicate, Function function )
-{
-    return BinaryPredicateWrapper<Predicate,Function>
-                                  (std::forward<Predicate>(predicate),
-                                   std::forward<Function>(function)
-                                  );
-}
-
-template<typename Predicate, typename Function, typename... Functions>
-auto wrap_binary_predicate( Predicate&& predicate, Function function, Functions&&... functions )
-{
-    return wrap_binary_predicate(
-                BinaryPredicateWrapper<Predicate,Function>(
-                    std::forward<Predicate>(predicate)
-                   ,std::forward<Function>(function))
-            ,std::forward<Functions>(functions)...
-            );
-}
-
-template<typename WPred, typename WFunc, typename Function>
-auto operator&&( BinaryPredicateWrapper<WPred,WFunc>&& predicate,
-                 Function function )
-{
-    return BinaryPredicateWrapper<BinaryPredicateWrapper<WPred,WFunc>,Function>
-                (std::forward<BinaryPredicateWrapper<WPred,WFunc>>(predicate)
-                ,std::forward<Function>(function)
-                );
-}
-
-template<typename Predicate, typename Function>
-using Pred = PredicateBase<PredicateWrapper<Predicate,Function>>;
-
-template<typename Predicate, typename Function>
-using BiPred = PredicateBase<BinaryPredicateWrapper<Predicate,Function>>;
-/* ------------------------------------------------------------------------- */
-
+auto hash_key( std::string_view key, std::uint64_t seed ) noexcept -> std::uint64_t;
 
-} // namespace
+// Orders lines by their hash
+void radix_sort( std::vector<HashedLine>& lines );
 
+auto random_sort( const commandline_args& args, std::uint64_t seed ) -> void;
 
-#endif /* sort_HEADER_INCLUDED_HPP_ */
 
+#endif /* SORT_V2_SORT_INCLUDED_HPP_ */
@@ -1,47 +1,41 @@
 #include <iostream>
 #include <vector>
-#include <list>
 #include <string>
+#include <string_view>
+#include <fstream>
+#include <memory>
 #include <algorithm>
 #include <functional>
-#include <future>
 #include <utility>
 #include <cctype>
+#include <random>
+#include <optional>
+#include <array>
+#include <numeric>
+#include <cstdint>
+#include <charconv>
+#include <system_error>
+#include <cstddef>
+#include <stdexcept>
 #include <gsl/gsl>
 
 #include "clara/clara.hpp"
 #include "sort.hpp"
+#include "jam/jam.hpp"
+#include "jam/external_sort.hpp"
+#include "jam/line_buffer.hpp"
+#include "jam/line_reader.hpp"
+#include "jam/line_writer.hpp"
+#include "jam/mapped_lines.hpp"
+#include "jam/key_field.hpp"
 
 using clara::Opt; using clara::Arg; using clara::Help;
 
-struct commandline_args
-{
-    bool ignore_case{false};
-    bool reverse_order{false};
-    bool ignore_leading_blanks{false};
-    bool dictionary_order{false};
-    bool random_sort{false};
-    bool check{false};
-    std::vector<std::string> infiles{};
-    std::string outfile{};
-    bool help_flag{false};
-};
-
-
-using Lines = std::list<std::string>;
-
-auto operator<<( std::ostream& os, const Lines& lines ) -> std::ostream&;
+auto parse_buffer_size( const std::string& size ) -> std::size_t;
 
-template<typename Predicate>
-auto process_file( const std::string& fname, Predicate predicate ) -> Lines;
+auto parse_random_seed( const std::string& seed ) -> std::uint64_t;
 
-template<typename Container, typename Predicate>
-auto process_files( const Container& files, Predicate predicate ) -> Lines;
-
-auto get_predicate( const commandline_args& args )
--> std::function<bool(const std::string&, const std::string&)>;
-
-auto write_lines( const std::string& fname, const Lines& container ) -> void;
+auto external_sort( const commandline_args& args, std::size_t memory_budget ) -> void;
 
 int main( int argc, char* argv[] )
 try{
@@ -53,8 +47,27 @@ try{
              ["-r"]["--reverse"]("Reverse the comparison")
         | Opt( cli_args.ignore_leading_blanks )
              ["-b"]["--ignore-leading-blanks"]("Ignore leading whitespace")
+        | Opt( cli_args.dictionary_order )
+             ["-d"]["--dictionary-order"]("Consider only blanks and alphanumeric characters")
+        | Opt( cli_args.merge )
+             ["-m"]["--merge"]("Merge already sorted files, do not sort")
+        | Opt( cli_args.check )
+             ["-c"]["--check"]("Check whether the input is sorted, do not sort")
+        | Opt( cli_args.random_sort )
+             ["-R"]["--random-sort"]("Shuffle, but group identical keys")
+        | Opt( cli_args.random_seed, "SEED" )
+             ["--random-seed"]("Seed of the -R hash, a random one by default")
+        | Opt( cli_args.key, "POS1[,POS2]" )
+             ["-k"]["--key"]("Sort on the key from field POS1 to POS2 (or the end of the line)."
+                             " A POS is F[.C], field F and character C, both counted from 1")
+        | Opt( cli_args.separator, "SEP" )
+             ["-t"]["--field-separator"]("Fields are separated by SEP instead of blank runs")
         | Opt( cli_args.outfile, "Output file")
              ["-o"]["--output-file"]
+        | Opt( cli_args.buffer_size, "SIZE" )
+             ["-S"]["--buffer-size"]
+             ("Sort in memory-bounded runs of SIZE, spilling them to temporary files."
+              " Suffixes K, M and G are accepted, the default unit is K")
         | Arg( cli_args.infiles, "[FILE]..." )
         | Help( cli_args.help_flag );
 
@@ -64,111 +77,91 @@ try{
         return 1;
     }
 
+    if( cli_args.check ){
+        return check_sorted(cli_args) ? 0 : 1;
+    }
+
+    if( cli_args.merge ){
+        merge_files(cli_args);
+        return 0;
+    }
+
+    if( cli_args.random_sort ){
+        random_sort(cli_args, cli_args.random_seed.empty()
+                                ? std::random_device{}() : parse_random_seed(cli_args.random_seed));
+        return 0;
+    }
+
+    if( !cli_args.buffer_size.empty() ){
+        external_sort(cli_args, parse_buffer_size(cli_args.buffer_size));
+        return 0;
+    }
+
     auto predicate = get_predicate(cli_args);
+    auto sorter = get_sorter(cli_args);
     if( !cli_args.infiles.empty() ){
-        auto lines = process_files(cli_args.infiles, predicate );
-        write_lines(cli_args.outfile, lines);
+        process_files(cli_args.infiles, sorter, predicate, cli_args.outfile);
     }
     else{
-        auto lines = jam::get_lines<Lines>(std::cin);
-        jam::sort_lines(lines, predicate);
-        write_lines(cli_args.outfile, lines);
+        const auto run = process_stream(std::cin, sorter);
+        write_lines(cli_args.outfile, run.lines);
     }
 }
 catch( const std::exception& ex ){
     std::cerr << ex.what() << std::endl;
+    return 1;
 }
 
-auto operator<<( std::ostream& os, const Lines& lines ) -> std::ostream&
-{
-    for( const auto& line : lines )
-        os << line << "\n";
-    return os;
-}
-
-template<typename Predicate>
-auto process_file( const std::string& fname, Predicate predicate ) -> Lines
-{
-    auto ifs = std::ifstream{fname};
-    auto lines = jam::get_lines<Lines>(ifs);
-    jam::sort_lines(lines, predicate);
-    return lines;
-}
 
-template<typename Container, typename Predicate>
-auto process_files( const Container& files, Predicate predicate ) -> Lines
+auto parse_buffer_size( const std::string& size ) -> std::size_t
 {
-    auto future_results = std::vector<std::future<Lines>>{};
-    for( const auto& file : files ){
-        future_results.push_back( std::async(
-            process_file<Predicate>, file, predicate
-        ));
-    }
-    auto results = Lines{};
-    for( auto&& fr : future_results ){
-        auto result = std::move(fr.get());
-        results.splice( std::upper_bound(results.cbegin(), results.cend(), result.front()),
-                        std::move(result) );
+    auto pos = std::size_t{0};
+    auto value = std::stoull(size, &pos);
+    auto unit = std::size_t{1024};
+    if( pos != size.size() ){
+        switch( std::toupper(static_cast<unsigned char>(size[pos])) ){
+            case 'B': unit = 1; break;
+            case 'K': unit = std::size_t{1} << 10; break;
+            case 'M': unit = std::size_t{1} << 20; break;
+            case 'G': unit = std::size_t{1} << 30; break;
+            default:
+                throw std::invalid_argument( "Invalid buffer size " + size );
+        }
+        if( pos + 1 != size.size() )
+            throw std::invalid_argument( "Invalid buffer size " + size );
     }
-    return results;
-}
-
-
-inline auto to_upper( const std::string& s ) -> std::string
-{
-    auto result = std::string(s.size(),'\0');
-    std::transform(s.cbegin(), s.cend(), result.begin(),
-                [](unsigned char ch){ return std::toupper(ch); } );
-    return result;
+    if( value == 0 )
+        throw std::invalid_argument( "Invalid buffer size " + size );
+    return value * unit;
 }
 
-inline auto ignore_leading_blanks( const std::string& s ) -> std::string
+auto parse_random_seed( const std::string& seed ) -> std::uint64_t
 {
-    const auto sbegin = s.find_first_not_of(" \t\n");
-    if( sbegin == std::string::npos )
-        return "";
-    return s.substr(sbegin);
+    auto value = std::uint64_t{0};
+    const auto* last = seed.data() + seed.size();
+    const auto result = std::from_chars(seed.data(), last, value);
+    if( result.ec != std::errc{} || result.ptr != last )
+        throw std::invalid_argument( "Invalid --random-seed '" + seed + "'" );
+    return value;
 }
 
-
-auto get_predicate( const commandline_args& args )
--> std::function<bool(const std::string&, const std::string&)>
-{
-    auto predicate = std::function<bool(const std::string&, const std::string&)>{};
-    if( args.reverse_order ){
-        if( args.ignore_case && args.ignore_leading_blanks )
-            predicate =  jam::wrap_binary_predicate(
-                std::greater<std::string>(), to_upper, ignore_leading_blanks
-            );
-        else if( args.ignore_case )
-            predicate =  jam::wrap_binary_predicate( std::greater<std::string>(), to_upper);
-        else if( args.ignore_leading_blanks )
-            predicate =  jam::wrap_binary_predicate( std::greater<std::string>(),
-                        ignore_leading_blanks );
-        else
-            predicate =  std::greater<std::string>();
-    }
-    else{
-        if( args.ignore_case && args.ignore_leading_blanks )
-            predicate =  jam::wrap_binary_predicate(
-                std::less<std::string>(), to_upper, ignore_leading_blanks
-            );
-        else if( args.ignore_case )
-            predicate =  jam::wrap_binary_predicate( std::less<std::string>(), to_upper);
-        else if( args.ignore_leading_blanks )
-            predicate =  jam::wrap_binary_predicate( std::less<std::string>(),
-                        ignore_leading_blanks );
-        else
-            predicate =  std::less<std::string>();
-    }
-    return predicate;
-}
-
-void write_lines( const std::string& fname, const Lines& lines )
+// Inputs that do not fit into memory - sort runs of at most memory_budget
+// bytes, spill them to disk and merge them into the output
+auto external_sort( const commandline_args& args, std::size_t memory_budget ) -> void
 {
-    auto ofs = std::ofstream{fname};
-    std::ostream& os = ofs ? ofs : std::cout;
-    for( const auto& line : lines ){
-        os << line << "\n";
-    }
+    visit_predicate( args, [&]( auto predicate ){
+        auto sorter = jam::ExternalSorter<decltype(predicate)>{ predicate, memory_budget };
+        if( args.infiles.empty() ){
+            jam::get_lines(std::cin, sorter);
+        }
+        for( const auto& file : args.infiles ){
+            auto ifs = std::ifstream{file, std::ios::binary};
+            if( !ifs )
+                throw std::runtime_error( "Failed to open the file " + file );
+            jam::get_lines(ifs, sorter);
+        }
+        auto writer = jam::LineWriter{args.outfile};
+        sorter.write_lines(writer);
+        writer.flush();
+    });
 }
@@ -0,0 +1,210 @@
+#include "sort.hpp"
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <future>
+#include <array>
+#include <numeric>
+
+#include "jam/external_sort.hpp"
+#include "jam/line_reader.hpp"
+#include "jam/mapped_lines.hpp"
+
+
+// Regular files are sorted in place in the page cache, pipes and other files
+// without a size are streamed into the buffer
+auto process_file( const std::string& fname, const Sorter& sorter ) -> Run
+{
+    if( !jam::MappedLines::can_map(fname) ){
+        auto ifs = std::ifstream{fname, std::ios::binary};
+        if( !ifs )
+            throw std::runtime_error( "Failed to open the file " + fname );
+        return process_stream(ifs, sorter);
+    }
+    auto run = Run{};
+    run.mapped.emplace(fname);
+    run.lines.assign( run.mapped->begin(), run.mapped->end() );
+    sorter(run.lines);
+    return run;
+}
+
+auto process_stream( std::istream& is, const Sorter& sorter ) -> Run
+{
+    auto run = Run{};
+    jam::get_lines(is, run.buffered);
+    run.lines.assign( run.buffered.begin(), run.buffered.end() );
+    sorter(run.lines);
+    return run;
+}
+
+// Every file is sorted on its own thread, the sorted runs are then merged
+// straight into the output
+auto process_files( const std::vector<std::string>& files, const Sorter& sorter,
+                    const Predicate& predicate, const std::string& outfile ) -> void
+{
+    auto future_results = std::vector<std::future<Run>>{};
+    for( const auto& file : files ){
+        future_results.push_back( std::async(
+            process_file, file, std::cref(sorter)
+        ));
+    }
+    auto runs = std::vector<Run>{};
+    for( auto&& fr : future_results ){
+        runs.push_back( fr.get() );
+    }
+    auto cursors = std::vector<RunCursor>{};
+    for( const auto& run : runs ){
+        cursors.emplace_back(run);
+    }
+    write_lines(outfile, cursors, predicate);
+}
+
+// Inputs that are sorted already - only the current line of each one is
+// kept in memory
+auto merge_files( const commandline_args& args ) -> void
+{
+    constexpr std::size_t block_size{1 << 16};
+    auto predicate = get_predicate(args);
+    auto inputs = std::vector<std::unique_ptr<std::ifstream>>{};
+    auto readers = std::vector<jam::LineReader>{};
+    readers.reserve( std::max<std::size_t>(args.infiles.size(), 1) );
+    if( args.infiles.empty() ){
+        readers.emplace_back( std::cin, block_size );
+    }
+    for( const auto& file : args.infiles ){
+        inputs.push_back( std::make_unique<std::ifstream>(file, std::ios::binary) );
+        if( !*inputs.back() )
+            throw std::runtime_error( "Failed to open the file " + file );
+        readers.emplace_back( *inputs.back(), block_size );
+    }
+    // The inputs are still being read while the output is written - an
+    // output that is also an input is written aside and renamed over it
+    const auto overwrites_input = !args.outfile.empty()
+        && std::any_of( args.infiles.cbegin(), args.infiles.cend(), [&args]( const auto& file ){
+               return jam::same_file(file, args.outfile);
+           });
+    if( !overwrites_input ){
+        write_lines(args.outfile, readers, predicate);
+        return;
+    }
+    const auto slash = args.outfile.rfind('/');
+    auto output = jam::TemporaryFile{ slash == std::string::npos ? std::string{"."}
+                                                                  : args.outfile.substr(0, slash + 1) };
+    write_lines(output.path(), readers, predicate);
+    output.keep_as(args.outfile);
+}
+
+
+auto get_predicate( const commandline_args& args ) -> Predicate
+{
+    return visit_predicate( args, []( auto predicate ){
+        return Predicate{predicate};
+    });
+}
+
+// -f, -d and -b transform every line - compute the keys once per line
+// instead of once per comparison
+auto get_sorter( const commandline_args& args ) -> Sorter
+{
+    return visit_predicate( args, []( auto predicate ){
+        return Sorter{ [predicate]( Views& lines ) mutable {
+            jam::sort_lines_by_key(lines, predicate);
+        }};
+    });
+}
+
+// -c: every line is compared with the one before it, up to the first line
+// out of order. Only the previous line is kept in memory. Like GNU sort it
+// takes a single input - the order across files would go unchecked.
+auto check_sorted( const commandline_args& args, std::ostream& diagnostics ) -> bool
+{
+    if( args.infiles.size() > 1 )
+        throw std::invalid_argument( "Extra operand '" + args.infiles[1] + "' not allowed with -c" );
+
+    auto predicate = get_predicate(args);
+    const auto check = [&]( std::istream& is, const std::string& name ){
+        auto reader = jam::LineReader{is};
+        auto previous = std::string{};
+        auto number = std::size_t{0};
+        for( std::string_view line; reader.next(line); ){
+            if( ++number > 1 && predicate(line, previous) ){
+                diagnostics << "sort: " << name << ":" << number << ": disorder: " << line << std::endl;
+                return false;
+            }
+            previous.assign( line.data(), line.size() );
+        }
+        return true;
+    };
+    if( args.infiles.empty() )
+        return check(std::cin, "-");
+    const auto& file = args.infiles.front();
+    auto ifs = std::ifstream{file, std::ios::binary};
+    if( !ifs )
+        throw std::runtime_error( "Failed to open the file " + file );
+    return check(ifs, file);
+}
+
+
+// FNV-1a over the key, started from the seed and finished with the splitmix64
+// mixer - FNV on its own leaves the high bits poorly mixed
+auto hash_key( std::string_view key, std::uint64_t seed ) noexcept -> std::uint64_t
+{
+    auto hash = std::uint64_t{0xcbf29ce484222325} ^ seed;
+    for( auto ch : key ){
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= std::uint64_t{0x100000001b3};
+    }
+    hash ^= hash >> 30;
+    hash *= std::uint64_t{0xbf58476d1ce4e5b9};
+    hash ^= hash >> 27;
+    hash *= std::uint64_t{0x94d049bb133111eb};
+    hash ^= hash >> 31;
+    return hash;
+}
+
+// LSD radix sort on the hash, one byte per pass
+void radix_sort( std::vector<HashedLine>& lines )
+{
+    auto buffer = std::vector<HashedLine>(lines.size());
+    for( unsigned shift = 0; shift != 64; shift += 8 ){
+        auto offsets = std::array<std::size_t, 257>{};
+        for( const auto& line : lines )
+            ++offsets[ ((line.hash >> shift) & 0xff) + 1 ];
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        for( const auto& line : lines )
+            buffer[ offsets[(line.hash >> shift) & 0xff]++ ] = line;
+        lines.swap(buffer);
+    }
+}
+
+// -R: lines are ordered by a seeded hash of their key. Identical keys hash
+// alike and end up next to each other, everything else in random order.
+// Radix sorting the hashes keeps it O(n).
+auto random_sort( const commandline_args& args, std::uint64_t seed ) -> void
+{
+    auto lines = Lines{};
+    if( args.infiles.empty() )
+        jam::get_lines(std::cin, lines);
+    for( const auto& file : args.infiles ){
+        auto ifs = std::ifstream{file, std::ios::binary};
+        if( !ifs )
+            throw std::runtime_error( "Failed to open the file " + file );
+        jam::get_lines(ifs, lines);
+    }
+
+    visit_predicate( args, [&]( auto predicate ){
+        auto hashed = std::vector<HashedLine>{};
+        hashed.reserve(lines.size());
+        for( std::size_t i = 0; i != lines.size(); ++i ){
+            const auto& key = jam::collation_key(predicate, lines[i]);
+            hashed.push_back( { hash_key(key, seed), i } );
+        }
+        radix_sort(hashed);
+        auto order = std::vector<std::size_t>{};
+        order.reserve(hashed.size());
+        for( const auto& line : hashed )
+            order.push_back(line.index);
+        lines.permute(order);
+    });
+    write_lines(args.outfile, lines);
+}
@@ -0,0 +1,76 @@
+#include "catch/catch.hpp"
+#include "sort.hpp"
+#include "jam/external_sort.hpp"
+#include "test_files.hpp"
+#include <sstream>
+#include <string>
+#include <stdexcept>
+
+namespace
+{
+auto is_sorted( const Input& lines, commandline_args args ) -> bool
+{
+    auto input = jam::TemporaryFile{};
+    write_file( input.path(), lines );
+    args.check = true;
+    args.infiles = { input.path() };
+    auto diagnostics = std::ostringstream{};
+    return check_sorted( args, diagnostics );
+}
+} // namespace
+
+
+TEST_CASE( "-c reports the first line out of order" )
+{
+    auto input = jam::TemporaryFile{};
+    write_file( input.path(), {"a", "b", "b", "d", "c", "e", "a"} );
+    auto args = commandline_args{};
+    args.check = true;
+    args.infiles = { input.path() };
+
+    auto diagnostics = std::ostringstream{};
+    REQUIRE_FALSE( check_sorted(args, diagnostics) );
+    REQUIRE( diagnostics.str() == "sort: " + input.path() + ":5: disorder: c\n" );
+}
+
+TEST_CASE( "-c accepts sorted and empty inputs" )
+{
+    REQUIRE( is_sorted( {}, {} ) );
+    REQUIRE( is_sorted( {"a"}, {} ) );
+    REQUIRE( is_sorted( {"a", "a", "b", "c"}, {} ) );
+}
+
+TEST_CASE( "-c checks the order the other options select" )
+{
+    auto args = commandline_args{};
+
+    SECTION( "-r" ){
+        REQUIRE_FALSE( is_sorted( {"c", "b", "a"}, args ) );
+        args.reverse_order = true;
+        REQUIRE( is_sorted( {"c", "b", "a"}, args ) );
+        REQUIRE_FALSE( is_sorted( {"a", "b", "c"}, args ) );
+    }
+
+    SECTION( "-f" ){
+        REQUIRE_FALSE( is_sorted( {"a", "B", "c"}, args ) );
+        args.ignore_case = true;
+        REQUIRE( is_sorted( {"a", "B", "c"}, args ) );
+    }
+
+    SECTION( "-k" ){
+        REQUIRE_FALSE( is_sorted( {"b 1", "a 2", "c 3"}, args ) );
+        args.key = "2,2";
+        REQUIRE( is_sorted( {"b 1", "a 2", "c 3"}, args ) );
+        REQUIRE_FALSE( is_sorted( {"a 2", "b 1"}, args ) );
+    }
+}
+
+TEST_CASE( "-c takes a single input" )
+{
+    auto first = jam::TemporaryFile{};
+    auto second = jam::TemporaryFile{};
+    auto args = commandline_args{};
+    args.check = true;
+    args.infiles = { first.path(), second.path() };
+    REQUIRE_THROWS_AS( check_sorted(args), std::invalid_argument );
+}
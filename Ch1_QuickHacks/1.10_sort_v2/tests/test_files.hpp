@@ -0,0 +1,27 @@
+#ifndef SORT_V2_TEST_FILES_INCLUDED_HPP_
+#define SORT_V2_TEST_FILES_INCLUDED_HPP_
+
+#include "jam/jam.hpp"
+#include <fstream>
+#include <string>
+#include <vector>
+
+using Input = std::vector<std::string>;
+
+// Writes every line followed by '\n'
+inline void write_file( const std::string& fname, const Input& lines )
+{
+    auto ofs = std::ofstream{fname, std::ios::binary};
+    for( const auto& line : lines ){
+        ofs << line << '\n';
+    }
+}
+
+inline auto read_file( const std::string& fname ) -> Input
+{
+    auto ifs = std::ifstream{fname, std::ios::binary};
+    return jam::get_lines<Input>(ifs);
+}
+
+
+#endif /* SORT_V2_TEST_FILES_INCLUDED_HPP_ */
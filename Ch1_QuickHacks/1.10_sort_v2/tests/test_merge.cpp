@@ -0,0 +1,131 @@
+#include "catch/catch.hpp"
+#include "sort.hpp"
+#include "jam/external_sort.hpp"
+#include "test_files.hpp"
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+namespace
+{
+auto random_lines( std::size_t count, unsigned seed ) -> Input
+{
+    auto generator = std::mt19937{seed};
+    auto letter = std::uniform_int_distribution<int>('a', 'z');
+    auto lines = Input(count);
+    for( auto& line : lines ){
+        line.resize(8);
+        for( auto& ch : line ){
+            ch = static_cast<char>(letter(generator));
+        }
+    }
+    return lines;
+}
+
+auto sorted( Input lines ) -> Input
+{
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+} // namespace
+
+
+TEST_CASE( "Sorting several files merges their runs" )
+{
+    auto first = jam::TemporaryFile{};
+    auto second = jam::TemporaryFile{};
+    auto output = jam::TemporaryFile{};
+    auto args = commandline_args{};
+    args.infiles = { first.path(), second.path() };
+    args.outfile = output.path();
+
+    SECTION( "runs that interleave line by line" ){
+        write_file( first.path(), {"f", "b", "d"} );
+        write_file( second.path(), {"g", "c", "e", "a"} );
+        process_files( args.infiles, get_sorter(args), get_predicate(args), args.outfile );
+        REQUIRE( read_file(output.path()) == Input{"a", "b", "c", "d", "e", "f", "g"} );
+    }
+
+    SECTION( "larger runs, reversed" ){
+        const auto lines = random_lines(5000, 1);
+        write_file( first.path(), Input(lines.begin(), lines.begin() + 2000) );
+        write_file( second.path(), Input(lines.begin() + 2000, lines.end()) );
+        args.reverse_order = true;
+        process_files( args.infiles, get_sorter(args), get_predicate(args), args.outfile );
+
+        auto expected = sorted(lines);
+        std::reverse(expected.begin(), expected.end());
+        REQUIRE( read_file(output.path()) == expected );
+    }
+}
+
+TEST_CASE( "A file is sorted as views into its mapping" )
+{
+    auto input = jam::TemporaryFile{};
+    write_file( input.path(), {"c", "a", "b"} );
+
+    const auto run = process_file( input.path(), get_sorter(commandline_args{}) );
+    REQUIRE( run.mapped.has_value() );
+    REQUIRE( run.buffered.empty() );
+    REQUIRE( run.lines == Views{"a", "b", "c"} );
+    const auto mapping = run.mapped->view();
+    for( const auto line : run.lines ){
+        REQUIRE( line.data() >= mapping.data() );
+        REQUIRE( line.data() + line.size() <= mapping.data() + mapping.size() );
+    }
+}
+
+TEST_CASE( "-m merges sorted files" )
+{
+    auto first = jam::TemporaryFile{};
+    auto second = jam::TemporaryFile{};
+    auto third = jam::TemporaryFile{};
+    const auto lines = random_lines(3000, 2);
+    write_file( first.path(), sorted(Input(lines.begin(), lines.begin() + 1000)) );
+    write_file( second.path(), sorted(Input(lines.begin() + 1000, lines.begin() + 2500)) );
+    write_file( third.path(), sorted(Input(lines.begin() + 2500, lines.end())) );
+
+    auto args = commandline_args{};
+    args.merge = true;
+    args.infiles = { first.path(), second.path(), third.path() };
+
+    SECTION( "into a file of its own" ){
+        auto output = jam::TemporaryFile{};
+        args.outfile = output.path();
+        merge_files(args);
+        REQUIRE( read_file(output.path()) == sorted(lines) );
+    }
+
+    SECTION( "into one of its inputs" ){
+        args.outfile = second.path();
+        merge_files(args);
+        REQUIRE( read_file(second.path()) == sorted(lines) );
+    }
+}
+
+TEST_CASE( "-m -o naming an input keeps inputs larger than the read blocks" )
+{
+    auto odd = jam::TemporaryFile{};
+    auto even = jam::TemporaryFile{};
+    auto odd_lines = Input{};
+    auto even_lines = Input{};
+    for( int i = 0; i != 100000; ++i ){
+        auto number = std::to_string(i);
+        number.insert( 0, 6 - number.size(), '0' );
+        (i % 2 != 0 ? odd_lines : even_lines).push_back(number);
+    }
+    write_file( odd.path(), odd_lines );
+    write_file( even.path(), even_lines );
+
+    auto args = commandline_args{};
+    args.merge = true;
+    args.infiles = { odd.path(), even.path() };
+    args.outfile = odd.path();
+    merge_files(args);
+
+    const auto merged = read_file(odd.path());
+    REQUIRE( merged.size() == 100000 );
+    REQUIRE( std::is_sorted(merged.begin(), merged.end()) );
+    REQUIRE( read_file(even.path()) == even_lines );
+}
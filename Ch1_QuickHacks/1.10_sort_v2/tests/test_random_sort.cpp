@@ -0,0 +1,109 @@
+#include "catch/catch.hpp"
+#include "sort.hpp"
+#include "jam/external_sort.hpp"
+#include "test_files.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+
+namespace
+{
+// Whether the lines with the same key form one block each
+template<typename Key>
+auto keys_grouped( const Input& lines, Key key ) -> bool
+{
+    auto seen = std::map<std::string, std::size_t>{};
+    for( std::size_t i = 0; i != lines.size(); ++i ){
+        const auto [it, inserted] = seen.emplace( key(lines[i]), i );
+        if( !inserted && it->second != i - 1 )
+            return false;
+        it->second = i;
+    }
+    return true;
+}
+
+auto random_sorted( const Input& lines, commandline_args args, std::uint64_t seed ) -> Input
+{
+    auto input = jam::TemporaryFile{};
+    auto output = jam::TemporaryFile{};
+    write_file( input.path(), lines );
+    args.random_sort = true;
+    args.infiles = { input.path() };
+    args.outfile = output.path();
+    random_sort( args, seed );
+    return read_file( output.path() );
+}
+
+auto make_input() -> Input
+{
+    auto generator = std::mt19937{3};
+    const auto words = Input{ "apple", "Apple", "APPLE", "pear", "Pear", "plum", "fig", "kiwi" };
+    auto pick = std::uniform_int_distribution<std::size_t>(0, words.size() - 1);
+    auto lines = Input{};
+    for( int i = 0; i != 500; ++i ){
+        lines.push_back( words[pick(generator)] );
+    }
+    return lines;
+}
+
+auto folded( std::string line ) -> std::string
+{
+    std::transform( line.begin(), line.end(), line.begin(),
+                    []( unsigned char ch ){ return static_cast<char>(std::toupper(ch)); } );
+    return line;
+}
+} // namespace
+
+
+TEST_CASE( "radix_sort orders lines by their hash" )
+{
+    auto generator = std::mt19937_64{5};
+    auto lines = std::vector<HashedLine>{};
+    for( std::size_t i = 0; i != 10000; ++i ){
+        // Few distinct high bytes, so that most passes see equal digits
+        lines.push_back( { generator() >> (i % 3 == 0 ? 56 : 0), i } );
+    }
+    auto expected = lines;
+    std::stable_sort( expected.begin(), expected.end(),
+                      []( const HashedLine& lhs, const HashedLine& rhs ){ return lhs.hash < rhs.hash; } );
+
+    radix_sort(lines);
+    REQUIRE( lines.size() == expected.size() );
+    for( std::size_t i = 0; i != lines.size(); ++i ){
+        REQUIRE( lines[i].hash == expected[i].hash );
+        REQUIRE( lines[i].index == expected[i].index );
+    }
+}
+
+TEST_CASE( "-R keeps identical keys together" )
+{
+    const auto input = make_input();
+    auto args = commandline_args{};
+
+    SECTION( "byte-wise keys" ){
+        const auto output = random_sorted( input, args, 11 );
+        REQUIRE( std::is_permutation(output.begin(), output.end(), input.begin()) );
+        REQUIRE( keys_grouped( output, []( const std::string& line ){ return line; } ) );
+    }
+
+    SECTION( "-f folds the keys first" ){
+        args.ignore_case = true;
+        const auto output = random_sorted( input, args, 11 );
+        REQUIRE( std::is_permutation(output.begin(), output.end(), input.begin()) );
+        REQUIRE( keys_grouped( output, folded ) );
+    }
+}
+
+TEST_CASE( "-R gives the same order for the same seed" )
+{
+    const auto input = make_input();
+    const auto args = commandline_args{};
+    const auto output = random_sorted( input, args, 42 );
+    REQUIRE( random_sorted(input, args, 42) == output );
+    REQUIRE( hash_key("apple", 42) == hash_key("apple", 42) );
+    REQUIRE( hash_key("apple", 42) != hash_key("apple", 43) );
+}
@@ -6,6 +6,11 @@
 #include <cctype>
 #include <stdexcept>
 #include <clara/clara.hpp>
+#include <jam/file_copy.hpp>
+#include <jam/line_numberer.hpp>
+#include <jam/file_prefetch.hpp>
+
+#include <unistd.h>
 
 using clara::Opt;
 using clara::Arg;
@@ -21,6 +26,7 @@ namespace
 bool gHelpFlag{false};
 bool gNumberLines{false};
 bool gNumberNonBlank{false};
+size_t gPrefetchDepth{jam::FilePrefetcher::default_depth};
 vector<string> gFiles;
 
 } // namespace
@@ -32,7 +38,6 @@ class FileException : public std::runtime_error
 };
 
 
-void write( const string&, size_t& );
 void concat( const vector<string>& files );
 
 
@@ -43,13 +48,16 @@ try{
             | Opt( gNumberLines )
                  ["-n"]["--number"]
                  ("Number all lines.")
-            | Opt( [](bool flag)
+            | Opt( [](bool)
                    {
                        if( gNumberLines ) gNumberLines = false;
                        gNumberNonBlank = true;
                    } )
                  ["-b"]["--number-nonblank"]
                  ("Number non-blank lines. Overrides --number")
+            | Opt( gPrefetchDepth, "depth" )
+                 ["-p"]["--prefetch"]
+                 ("Number of files to open and read ahead. 0 turns it off.")
             | Arg( gFiles, "Files to concatenate" );
     auto result = cliparser.parse( clara::Args(argc, argv) );
     if( !result || gHelpFlag ){
@@ -62,41 +70,36 @@ try{
 catch( const FileException& e ){
     std::cerr << e.what() << std::endl;
 }
+catch( const std::exception& e ){
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
 
 
-void write( const string& file, size_t& line_number )
+// Hands the descriptor of every file, in order, to process. The files after
+// the current one are opened and read ahead in the background.
+template<typename Function>
+void for_each_file( const vector<string>& files, Function process )
 {
-    bool line_begin{true};
-    std::ifstream ifs{file};
-    if( !ifs ){
-        throw FileException( "Failed to open the file " + file );
-    }
-
-    for( char ch; ifs.get(ch); ){
-        if( gNumberLines && line_begin ){
-            cout << line_number << ".\t";
-            ++line_number;
-            line_begin = false;
-        }
-        if( gNumberNonBlank && line_begin && ch != '\n' ){
-            cout << line_number << ".\t";
-            ++line_number;
-            line_begin = false;
-        }
-
-        cout << ch;
-        
-        if( ch == '\n' ){
-            
-            line_begin = true;
+    auto prefetcher = jam::FilePrefetcher{ files, gPrefetchDepth };
+    for( auto file = jam::PrefetchedFile{}; prefetcher.next( file ); ){
+        if( file.fd() == -1 ){
+            throw FileException( "Failed to open the file " + file.name() );
         }
+        process( file.fd() );
     }
 }
 
 void concat( const vector<string>& files )
 {
-    size_t line_number{1};
-    for( const auto& file : files ){
-        write( file, line_number );
+    if( !gNumberLines && !gNumberNonBlank ){
+        // Without numbering the bytes never have to pass through user space
+        for_each_file( files, []( int fd ){ jam::copy_fd( fd, STDOUT_FILENO ); } );
+        return;
     }
+
+    auto numberer = jam::LineNumberer{ STDOUT_FILENO, gNumberNonBlank
+                                                      ? jam::LineNumberer::Mode::nonblank
+                                                      : jam::LineNumberer::Mode::all };
+    for_each_file( files, [&]( int fd ){ numberer.number( fd ); } );
 }
@@ -0,0 +1,62 @@
+#ifndef FIND_EXECUTOR_INCLUDED_HPP_
+#define FIND_EXECUTOR_INCLUDED_HPP_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <sys/types.h>
+
+
+// Runs the command of -exec for the matches, the way find does:
+//  - each  (-exec cmd {} \;) once per path, "{}" replaced by it wherever it
+//          occurs in the words of the command
+//  - batch (-exec cmd {} +)  with as many paths in place of the final "{}" as
+//          fit into ARG_MAX beside the environment
+// Up to jobs children run at the same time, add() waits for one of them only
+// once they are all busy - the paths keep coming in the meantime. The
+// children share find's stdin, stdout and stderr.
+//
+// Not thread safe, the paths are all added from the thread that emits them.
+class Executor
+{
+public:
+    enum class Mode
+    {
+        each,
+        batch
+    };
+
+    // Takes the words of -exec, up to and without the ';' or '+' ending them.
+    // Throws std::invalid_argument if there is no command, or for a batch
+    // that does not end with "{}".
+    Executor( std::vector<std::string> command, Mode mode, unsigned jobs = 1 );
+    Executor( const Executor& ) = delete;
+    Executor& operator=( const Executor& ) = delete;
+    // Waits for the children that are still running
+    ~Executor();
+
+    void add( const std::string& path );
+    // Runs what is left of the batch and waits for all children. Returns
+    // false if a command could not be run or, for batches, did not succeed -
+    // find's exit status.
+    auto finish() -> bool;
+
+private:
+    void run( const std::vector<std::string>& argv );
+    void wait_for_one();
+
+    std::vector<std::string> m_command;
+    Mode m_mode;
+    unsigned m_jobs;
+    // Running commands, oldest first
+    std::vector<pid_t> m_children{};
+    bool m_succeeded{true};
+    // The batch, its paths follow the words of the command
+    std::vector<std::string> m_arguments{};
+    std::size_t m_size{0};
+    std::size_t m_limit{0};
+};
+
+
+#endif /* FIND_EXECUTOR_INCLUDED_HPP_ */
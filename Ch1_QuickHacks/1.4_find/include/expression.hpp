@@ -0,0 +1,52 @@
+#ifndef FIND_EXPRESSION_INCLUDED_HPP_
+#define FIND_EXPRESSION_INCLUDED_HPP_
+
+#include <jam/directory_reader.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <ctime>
+
+
+// A find(1) expression, compiled into a tree of tests:
+//
+//     -name PATTERN  -iname PATTERN  -regex REGEX
+//     -type [fdlbcps]  -size [+-]N[bckwMG]  -mtime [+-]N  -mmin [+-]N
+//     -perm MODE|-MODE|/MODE   (octal)
+//     ( EXPR )  ! EXPR  -not EXPR  EXPR -a EXPR  EXPR -and EXPR  EXPR EXPR
+//     EXPR -o EXPR  EXPR -or EXPR
+//
+// --name, --iname and --regex are accepted as well. An empty expression
+// matches every entry.
+//
+// None of the tests has side effects, so the operands of every -and and -or
+// are put in the order that is cheapest on average: an estimated cost and
+// chance of success per test, names and d_type first, tests that need the
+// entry's stat() last. An entry is stat'ed only if one of those is reached,
+// and at most once.
+class Expression
+{
+public:
+    class Node;
+
+    // Number of arguments the expression word takes, -1 if it is none
+    static auto arguments( std::string_view word ) noexcept -> int;
+
+    // Throws std::invalid_argument for an expression find would reject
+    explicit Expression( const std::vector<std::string>& tokens );
+    Expression( Expression&& ) noexcept;
+    Expression& operator=( Expression&& ) noexcept;
+    ~Expression();
+
+    auto operator()( std::string_view name, jam::DirectoryEntry& entry ) const -> bool;
+
+    // The tree in evaluation order, e.g. "( -name *.txt -a -size +1k )"
+    auto to_string() const -> std::string;
+
+private:
+    std::unique_ptr<Node> m_root;
+};
+
+
+#endif /* FIND_EXPRESSION_INCLUDED_HPP_ */
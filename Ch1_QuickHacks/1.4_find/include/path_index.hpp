@@ -0,0 +1,81 @@
+#ifndef FIND_PATH_INDEX_INCLUDED_HPP_
+#define FIND_PATH_INDEX_INCLUDED_HPP_
+
+#include "search.hpp"
+#include <string>
+#include <cstddef>
+
+
+// A locate-style database of every path below a directory, so that repeated
+// searches of a large tree need not crawl it again.
+//
+// The file is a header followed by one record per directory, in depth-first
+// order with the entries of a directory sorted by name:
+//
+//     path    front-coded against the path of the previous directory
+//     mtime   seconds and nanoseconds
+//     count   number of entries, then the size of the entries in bytes
+//     entries type byte and name, front-coded against the previous name
+//
+// Numbers are LEB128 varints and front coding stores the length of the prefix
+// shared with the previous string, then the length and the bytes of the rest.
+// A search maps the file and decodes it front to back, the directories that
+// are not asked for are skipped by their size.
+//
+// A directory gets a new mtime whenever an entry is created, removed or
+// renamed in it, so a refresh stat()s every indexed directory but only reads
+// the ones whose mtime changed - the entries of the others are copied over.
+class PathIndex
+{
+public:
+    struct Statistics
+    {
+        std::size_t directories{0};
+        std::size_t entries{0};
+        // Directories that had to be read, the rest were taken from the index
+        std::size_t read{0};
+        // Directories that could not be read, they were reported on stderr
+        std::size_t errors{0};
+    };
+
+    // Crawls root and writes its index to db, replacing the file only once it
+    // is complete. The root is indexed as an absolute, normalised path.
+    // Directories that cannot be read are reported on stderr.
+    static auto build( const std::string& db, const std::string& root ) -> Statistics;
+    // Brings the index in db up to date, root defaults to the one it was
+    // built for
+    static auto refresh( const std::string& db, const std::string& root = {} ) -> Statistics;
+
+    // Maps db, throws std::runtime_error if it is no index
+    explicit PathIndex( const std::string& db );
+    PathIndex( const PathIndex& ) = delete;
+    PathIndex& operator=( const PathIndex& ) = delete;
+    ~PathIndex();
+
+    auto root() const noexcept -> const std::string& { return m_root; }
+    auto directories() const noexcept -> std::size_t { return m_directories; }
+    auto entries() const noexcept -> std::size_t { return m_entries; }
+
+    // Emits the indexed paths in and below the directory under - the whole
+    // index if it is empty - that match, as absolute paths. under is
+    // normalised like the root, std::runtime_error is thrown if it is neither
+    // in nor above it. The entries are stat'ed only for the predicate, then it
+    // is the file system as it is now that answers. Entries that cannot be
+    // stat'ed are reported and do not match, false is returned then.
+    auto search( const std::string& under, const Search::Predicate& match,
+                 const Search::Emit& emit ) const -> bool;
+
+private:
+    class Builder;
+
+    const char* m_data{nullptr};
+    std::size_t m_size{0};
+    std::string m_root;
+    std::size_t m_directories{0};
+    std::size_t m_entries{0};
+    // Offset of the first directory record
+    std::size_t m_records{0};
+};
+
+
+#endif /* FIND_PATH_INDEX_INCLUDED_HPP_ */
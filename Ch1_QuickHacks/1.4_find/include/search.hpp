@@ -0,0 +1,60 @@
+#ifndef FIND_SEARCH_INCLUDED_HPP_
+#define FIND_SEARCH_INCLUDED_HPP_
+
+#include <jam/directory_reader.hpp>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <cstddef>
+
+
+// Parallel directory walk that hands the matching paths to a single output
+// callback while the walk is still going on.
+//
+// The directories are read by a jam::WorkStealingPool; emit() is only ever
+// called from the thread that called run(), one match at a time.
+//  - unordered: matches go through a lock-free queue and are emitted as soon
+//    as they are found.
+//  - directory order: the matches of a directory come before those of its
+//    subdirectories, directories in the order they were listed - the same
+//    output for every run. At most about buffer_limit matches and
+//    directories found wait for the ones before them; beyond that the
+//    workers hold back and the emitting thread reads the next directories in
+//    order itself.
+class Search
+{
+public:
+    enum class Order
+    {
+        unordered,
+        directory
+    };
+
+    // Decides whether an entry matches. name is the entry name, entry gives
+    // its type and, when asked for, its status.
+    using Predicate = std::function<bool( std::string_view name, jam::DirectoryEntry& entry )>;
+    using Emit = std::function<void( const std::string& path )>;
+    // Called when the walk is about to wait for matches, so buffered output
+    // can go out
+    using Idle = std::function<void()>;
+
+    static constexpr std::size_t default_buffer_limit{1 << 16};
+
+    explicit Search( unsigned jobs = 0, Order order = Order::directory,
+                     std::size_t buffer_limit = default_buffer_limit );
+
+    // Walks the tree below root. Directories that cannot be read are reported
+    // on stderr and skipped, as are entries the predicate cannot stat. Returns
+    // false if there was any such error. Exceptions thrown by emit() end the
+    // walk and are rethrown.
+    auto run( const std::string& root, const Predicate& match, const Emit& emit,
+              const Idle& idle = []{} ) -> bool;
+
+private:
+    unsigned m_jobs;
+    Order m_order;
+    std::size_t m_buffer_limit;
+};
+
+
+#endif /* FIND_SEARCH_INCLUDED_HPP_ */
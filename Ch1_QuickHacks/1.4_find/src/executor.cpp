@@ -0,0 +1,174 @@
+#include "executor.hpp"
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+using std::string; using std::vector;
+
+
+namespace
+{
+// POSIX leaves this much room for the child to change its environment
+constexpr std::size_t arg_max_headroom{2048};
+
+// What an argument takes of ARG_MAX - the string and its pointer
+auto argument_size( const string& argument ) noexcept -> std::size_t
+{
+    return argument.size() + 1 + sizeof(char*);
+}
+
+auto environment_size() noexcept -> std::size_t
+{
+    auto size = sizeof(char*);
+    for( auto variable = environ; *variable != nullptr; ++variable ){
+        size += std::strlen(*variable) + 1 + sizeof(char*);
+    }
+    return size;
+}
+
+// Whether pid has ended, its exit status is put in status then. A child that
+// cannot be waited for counts as ended, and as failed.
+auto wait_for( pid_t pid, int& status, int options ) noexcept -> bool
+{
+    for( ;; ){
+        const auto result = ::waitpid( pid, &status, options );
+        if( result == pid )
+            return true;
+        if( result == 0 )
+            return false;
+        if( errno != EINTR ){
+            status = -1;
+            return true;
+        }
+    }
+}
+
+void replace_all( string& word, const string& path )
+{
+    for( auto pos = word.find("{}"); pos != string::npos; pos = word.find("{}", pos + path.size()) ){
+        word.replace( pos, 2, path );
+    }
+}
+} // namespace
+
+
+Executor::Executor( vector<string> command, Mode mode, unsigned jobs )
+    : m_command{std::move(command)}
+    , m_mode{mode}
+    , m_jobs{std::max(jobs, 1u)}
+{
+    if( m_command.empty() )
+        throw std::invalid_argument( "-exec needs a command" );
+    if( m_mode == Mode::each )
+        return;
+
+    if( m_command.back() != "{}" )
+        throw std::invalid_argument( "-exec ... + needs '{}' right before the '+'" );
+    m_command.pop_back();
+    m_arguments = m_command;
+
+    // The paths get whatever the command and the environment leave
+    const auto arg_max = ::sysconf( _SC_ARG_MAX );
+    auto used = environment_size() + arg_max_headroom + sizeof(char*);
+    for( const auto& word : m_command ){
+        used += argument_size( word );
+    }
+    const auto available = arg_max > 0 ? static_cast<std::size_t>(arg_max) : std::size_t{_POSIX_ARG_MAX};
+    m_limit = available > used ? available - used : 0;
+}
+
+Executor::~Executor()
+{
+    while( !m_children.empty() ){
+        wait_for_one();
+    }
+}
+
+void Executor::add( const string& path )
+{
+    if( m_mode == Mode::each ){
+        auto argv = m_command;
+        for( auto& word : argv ){
+            replace_all( word, path );
+        }
+        run( argv );
+        return;
+    }
+
+    // A path that does not fit even alone still gets a command of its own,
+    // exec then tells what is wrong with it
+    const auto size = argument_size( path );
+    if( m_size != 0 && m_size + size > m_limit ){
+        run( m_arguments );
+        m_arguments.resize( m_command.size() );
+        m_size = 0;
+    }
+    m_arguments.push_back( path );
+    m_size += size;
+}
+
+auto Executor::finish() -> bool
+{
+    if( m_mode == Mode::batch && m_size != 0 ){
+        run( m_arguments );
+        m_arguments.resize( m_command.size() );
+        m_size = 0;
+    }
+    while( !m_children.empty() ){
+        wait_for_one();
+    }
+    return m_succeeded;
+}
+
+void Executor::run( const vector<string>& arguments )
+{
+    if( m_children.size() == m_jobs )
+        wait_for_one();
+
+    auto argv = vector<char*>{};
+    argv.reserve( arguments.size() + 1 );
+    for( const auto& argument : arguments ){
+        argv.push_back( const_cast<char*>(argument.c_str()) );
+    }
+    argv.push_back( nullptr );
+
+    auto pid = pid_t{};
+    if( const auto error = ::posix_spawnp( &pid, argv[0], nullptr, nullptr, argv.data(), environ );
+        error != 0 ){
+        std::cerr << "find: Failed to run " << arguments.front() << ": " << std::strerror(error) << '\n';
+        m_succeeded = false;
+        return;
+    }
+    m_children.push_back( pid );
+}
+
+void Executor::wait_for_one()
+{
+    // Only the children of this executor are waited for - the ones of
+    // another -exec are its own to count. Any that is done already frees its
+    // slot, otherwise the oldest one is waited for.
+    auto status = 0;
+    auto done = m_children.end();
+    for( auto child = m_children.begin(); child != m_children.end() && done == m_children.end(); ++child ){
+        if( wait_for( *child, status, WNOHANG ) )
+            done = child;
+    }
+    if( done == m_children.end() ){
+        done = m_children.begin();
+        wait_for( *done, status, 0 );
+    }
+    m_children.erase( done );
+    // The exit status of a command run for each path is the value of the
+    // test for find, it is no error
+    if( m_mode == Mode::batch && !(WIFEXITED(status) && WEXITSTATUS(status) == 0) )
+        m_succeeded = false;
+}
@@ -0,0 +1,438 @@
+#include "expression.hpp"
+#include <jam/glob.hpp>
+#include <regex>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <charconv>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+using std::string; using std::string_view; using std::vector;
+using std::unique_ptr; using std::make_unique;
+
+
+namespace
+{
+using Test = std::function<bool( string_view name, jam::DirectoryEntry& entry )>;
+
+// Rough cost of a test, relative to matching a name against a glob, and the
+// chance that it holds - enough to tell cheap from expensive
+constexpr double name_cost{1.0};
+constexpr double regex_cost{20.0};
+constexpr double type_cost{2.0};        // d_type, a stat() where it is missing
+constexpr double stat_cost{50.0};
+
+enum class Compare { less, equal, greater };
+
+// "+N", "-N" or "N", followed by what the number leaves over
+struct Number
+{
+    Compare compare;
+    long long value;
+    string_view suffix;
+};
+
+auto parse_number( const string& word, string_view argument ) -> Number
+{
+    auto number = Number{ Compare::equal, 0, {} };
+    if( !argument.empty() && (argument.front() == '+' || argument.front() == '-') ){
+        number.compare = argument.front() == '+' ? Compare::greater : Compare::less;
+        argument.remove_prefix(1);
+    }
+    const auto [end, error] = std::from_chars( argument.data(), argument.data() + argument.size(), number.value );
+    if( error != std::errc{} || end == argument.data() ){
+        throw std::invalid_argument( "Invalid argument '" + string{argument} + "' to " + word );
+    }
+    number.suffix = argument.substr( static_cast<std::size_t>(end - argument.data()) );
+    return number;
+}
+
+auto compare( Compare how, long long value, long long with ) noexcept -> bool
+{
+    switch( how ){
+    case Compare::less: return value < with;
+    case Compare::greater: return value > with;
+    case Compare::equal: break;
+    }
+    return value == with;
+}
+
+// find's units for -size, 512 byte blocks without one
+auto size_unit( const string& word, string_view suffix ) -> long long
+{
+    if( suffix.empty() || suffix == "b" ) return 512;
+    if( suffix == "c" ) return 1;
+    if( suffix == "w" ) return 2;
+    if( suffix == "k" ) return 1024;
+    if( suffix == "M" ) return 1024 * 1024;
+    if( suffix == "G" ) return 1024 * 1024 * 1024;
+    throw std::invalid_argument( "Invalid unit '" + string{suffix} + "' to " + word );
+}
+
+auto type_test( const string& word, string_view argument ) -> std::pair<Test, double>
+{
+    if( argument.size() != 1 ){
+        throw std::invalid_argument( "Invalid argument '" + string{argument} + "' to " + word );
+    }
+    // Devices, fifos and sockets share EntryType::other, the mode tells them apart
+    const auto other = []( mode_t format ) -> Test {
+        return [format]( string_view, jam::DirectoryEntry& entry ){
+            return entry.type() == jam::EntryType::other
+                && (entry.status().st_mode & S_IFMT) == format;
+        };
+    };
+    const auto is = []( jam::EntryType type ) -> Test {
+        return [type]( string_view, jam::DirectoryEntry& entry ){ return entry.type() == type; };
+    };
+    switch( argument.front() ){
+    case 'f': return { is(jam::EntryType::regular), 0.8 };
+    case 'd': return { is(jam::EntryType::directory), 0.15 };
+    case 'l': return { is(jam::EntryType::symlink), 0.03 };
+    case 'b': return { other(S_IFBLK), 0.01 };
+    case 'c': return { other(S_IFCHR), 0.01 };
+    case 'p': return { other(S_IFIFO), 0.01 };
+    case 's': return { other(S_IFSOCK), 0.01 };
+    }
+    throw std::invalid_argument( "Unknown type '" + string{argument} + "' to " + word );
+}
+
+auto perm_test( const string& word, string_view argument ) -> Test
+{
+    auto how = argument.empty() ? '\0' : argument.front();
+    if( how == '-' || how == '/' )
+        argument.remove_prefix(1);
+    else
+        how = '=';
+    auto mode = 0u;
+    const auto [end, error] = std::from_chars( argument.data(), argument.data() + argument.size(), mode, 8 );
+    if( error != std::errc{} || end != argument.data() + argument.size() || mode > 07777 ){
+        throw std::invalid_argument( "Invalid mode '" + string{argument} + "' to " + word
+                                     + " - only octal modes are supported" );
+    }
+    return [how, mode]( string_view, jam::DirectoryEntry& entry ){
+        const auto bits = static_cast<unsigned>(entry.status().st_mode) & 07777u;
+        switch( how ){
+        case '-': return (bits & mode) == mode;
+        case '/': return mode == 0 || (bits & mode) != 0;
+        }
+        return bits == mode;
+    };
+}
+} // namespace
+
+
+/* Expression tree */
+/* ------------------------------------------------------------------------- */
+class Expression::Node
+{
+public:
+    virtual ~Node() = default;
+    virtual auto evaluate( string_view name, jam::DirectoryEntry& entry ) const -> bool = 0;
+    // Orders the operands below this node, and sets cost and probability
+    virtual void optimize() { }
+    virtual auto to_string() const -> string = 0;
+
+    // Expected cost of evaluating the node, and the chance that it holds
+    double cost{1.0};
+    double probability{0.5};
+};
+
+namespace
+{
+class TestNode : public Expression::Node
+{
+public:
+    TestNode( string label, Test test, double test_cost, double test_probability )
+        : m_label{std::move(label)}
+        , m_test{std::move(test)}
+    {
+        cost = test_cost;
+        probability = test_probability;
+    }
+
+    auto evaluate( string_view name, jam::DirectoryEntry& entry ) const -> bool override
+    {
+        return m_test( name, entry );
+    }
+
+    auto to_string() const -> string override { return m_label; }
+
+private:
+    string m_label;
+    Test m_test;
+};
+
+class NotNode : public Expression::Node
+{
+public:
+    explicit NotNode( unique_ptr<Node> operand ) : m_operand{std::move(operand)} { }
+
+    auto evaluate( string_view name, jam::DirectoryEntry& entry ) const -> bool override
+    {
+        return !m_operand->evaluate( name, entry );
+    }
+
+    void optimize() override
+    {
+        m_operand->optimize();
+        cost = m_operand->cost;
+        probability = 1.0 - m_operand->probability;
+    }
+
+    auto to_string() const -> string override { return "! " + m_operand->to_string(); }
+
+private:
+    unique_ptr<Node> m_operand;
+};
+
+// -and or -or of any number of operands, evaluated left to right until one
+// decides the result
+class JunctionNode : public Expression::Node
+{
+public:
+    JunctionNode( bool is_and, unique_ptr<Node> lhs, unique_ptr<Node> rhs )
+        : m_is_and{is_and}
+    {
+        add( std::move(lhs) );
+        add( std::move(rhs) );
+    }
+
+    auto evaluate( string_view name, jam::DirectoryEntry& entry ) const -> bool override
+    {
+        for( const auto& operand : m_operands ){
+            if( operand->evaluate(name, entry) != m_is_and )
+                return !m_is_and;
+        }
+        return m_is_and;
+    }
+
+    // An operand that decides the result - fails an -and, holds for an -or -
+    // ends the evaluation, so the best order sorts them by cost over the
+    // chance of deciding
+    void optimize() override
+    {
+        for( auto& operand : m_operands ){
+            operand->optimize();
+        }
+        const auto rank = [this]( const unique_ptr<Node>& node ){
+            const auto decides = m_is_and ? 1.0 - node->probability : node->probability;
+            return decides > 0.0 ? node->cost / decides : std::numeric_limits<double>::infinity();
+        };
+        std::stable_sort( m_operands.begin(), m_operands.end(),
+                          [&]( const auto& lhs, const auto& rhs ){ return rank(lhs) < rank(rhs); } );
+
+        // Chance that evaluation gets past the operands so far
+        auto reached = 1.0;
+        cost = 0.0;
+        for( const auto& operand : m_operands ){
+            cost += reached * operand->cost;
+            reached *= m_is_and ? operand->probability : 1.0 - operand->probability;
+        }
+        probability = m_is_and ? reached : 1.0 - reached;
+    }
+
+    auto to_string() const -> string override
+    {
+        auto text = string{"("};
+        for( std::size_t i = 0; i != m_operands.size(); ++i ){
+            if( i != 0 )
+                text += m_is_and ? " -a" : " -o";
+            text += ' ' + m_operands[i]->to_string();
+        }
+        return text + " )";
+    }
+
+private:
+    // a -a (b -a c) is a -a b -a c, all of it up for reordering
+    void add( unique_ptr<Node> operand )
+    {
+        if( auto* junction = dynamic_cast<JunctionNode*>(operand.get());
+            junction != nullptr && junction->m_is_and == m_is_and ){
+            for( auto& nested : junction->m_operands )
+                m_operands.push_back( std::move(nested) );
+            return;
+        }
+        m_operands.push_back( std::move(operand) );
+    }
+
+    bool m_is_and;
+    vector<unique_ptr<Node>> m_operands{};
+};
+
+class TrueNode : public Expression::Node
+{
+public:
+    TrueNode() { cost = 0.0; probability = 1.0; }
+    auto evaluate( string_view, jam::DirectoryEntry& ) const -> bool override { return true; }
+    auto to_string() const -> string override { return "-true"; }
+};
+
+
+// Recursive descent, binding tightest to loosest: ( ), !, -a, -o
+class Parser
+{
+public:
+    explicit Parser( const vector<string>& tokens )
+        : m_tokens{tokens}
+        , m_now{ std::time(nullptr) }
+        { }
+
+    auto parse() -> unique_ptr<Expression::Node>
+    {
+        if( m_tokens.empty() )
+            return make_unique<TrueNode>();
+        auto root = parse_or();
+        if( m_pos != m_tokens.size() )
+            throw std::invalid_argument( "Unexpected '" + m_tokens[m_pos] + "' in the expression" );
+        return root;
+    }
+
+private:
+    auto peek() const -> string_view
+    {
+        return m_pos < m_tokens.size() ? string_view{m_tokens[m_pos]} : string_view{};
+    }
+
+    auto take() -> const string&
+    {
+        if( m_pos == m_tokens.size() ){
+            const auto after = m_tokens.empty() ? string{} : " after '" + m_tokens.back() + "'";
+            throw std::invalid_argument( "Expected more of the expression" + after );
+        }
+        return m_tokens[m_pos++];
+    }
+
+    auto parse_or() -> unique_ptr<Expression::Node>
+    {
+        auto lhs = parse_and();
+        while( peek() == "-o" || peek() == "-or" ){
+            take();
+            lhs = make_unique<JunctionNode>( false, std::move(lhs), parse_and() );
+        }
+        return lhs;
+    }
+
+    auto parse_and() -> unique_ptr<Expression::Node>
+    {
+        auto lhs = parse_not();
+        for( auto next = peek(); !next.empty() && next != "-o" && next != "-or" && next != ")"; next = peek() ){
+            // Two expressions side by side are joined by an implicit -a
+            if( next == "-a" || next == "-and" )
+                take();
+            lhs = make_unique<JunctionNode>( true, std::move(lhs), parse_not() );
+        }
+        return lhs;
+    }
+
+    auto parse_not() -> unique_ptr<Expression::Node>
+    {
+        if( peek() == "!" || peek() == "-not" ){
+            take();
+            return make_unique<NotNode>( parse_not() );
+        }
+        return parse_primary();
+    }
+
+    auto parse_primary() -> unique_ptr<Expression::Node>
+    {
+        const auto& word = take();
+        if( word == "(" ){
+            auto inner = parse_or();
+            if( peek() != ")" )
+                throw std::invalid_argument( "Expected ')' in the expression" );
+            take();
+            return inner;
+        }
+        if( Expression::arguments(word) != 1 )
+            throw std::invalid_argument( "Unexpected '" + word + "' in the expression" );
+
+        const auto& argument = take();
+        const auto label = word + " " + argument;
+        // -name and --name alike
+        const auto test = word.substr( word.find_first_not_of('-') );
+
+        if( test == "name" || test == "iname" ){
+            auto glob = jam::Glob{ argument, test == "iname" };
+            return make_unique<TestNode>( label, [glob = std::move(glob)]( string_view name, jam::DirectoryEntry& ){
+                return glob(name);
+            }, name_cost, 0.1 );
+        }
+        if( test == "regex" ){
+            auto re = std::regex{ argument };
+            return make_unique<TestNode>( label, [re = std::move(re)]( string_view name, jam::DirectoryEntry& ){
+                return std::regex_search( name.begin(), name.end(), re );
+            }, regex_cost, 0.1 );
+        }
+        if( test == "type" ){
+            auto [type, chance] = type_test( word, argument );
+            return make_unique<TestNode>( label, std::move(type), type_cost, chance );
+        }
+        if( test == "size" ){
+            const auto number = parse_number( word, argument );
+            const auto unit = size_unit( word, number.suffix );
+            return make_unique<TestNode>( label, [number, unit]( string_view, jam::DirectoryEntry& entry ){
+                // Counted in whole units, rounded up
+                const auto size = static_cast<long long>(entry.status().st_size);
+                return compare( number.compare, (size + unit - 1) / unit, number.value );
+            }, stat_cost, 0.5 );
+        }
+        if( test == "mtime" || test == "mmin" ){
+            const auto number = parse_number( word, argument );
+            if( !number.suffix.empty() )
+                throw std::invalid_argument( "Invalid argument '" + argument + "' to " + word );
+            const auto period = test == "mtime" ? 24 * 60 * 60 : 60;
+            return make_unique<TestNode>( label, [number, period, now = m_now]( string_view, jam::DirectoryEntry& entry ){
+                // Age in whole periods, the rest dropped
+                const auto age = static_cast<long long>(now - entry.status().st_mtime) / period;
+                return compare( number.compare, age, number.value );
+            }, stat_cost, 0.5 );
+        }
+        if( test == "perm" ){
+            return make_unique<TestNode>( label, perm_test(word, argument), stat_cost, 0.5 );
+        }
+        throw std::invalid_argument( "Unexpected '" + word + "' in the expression" );
+    }
+
+    const vector<string>& m_tokens;
+    std::size_t m_pos{0};
+    std::time_t m_now;
+};
+} // namespace
+/* ------------------------------------------------------------------------- */
+
+
+auto Expression::arguments( string_view word ) noexcept -> int
+{
+    for( const auto test : { "-name", "-iname", "-regex", "--name", "--iname", "--regex",
+                             "-type", "-size", "-mtime", "-mmin", "-perm" } ){
+        if( word == test )
+            return 1;
+    }
+    for( const auto op : { "!", "-not", "-a", "-and", "-o", "-or", "(", ")" } ){
+        if( word == op )
+            return 0;
+    }
+    return -1;
+}
+
+Expression::Expression( const vector<string>& tokens )
+    : m_root{ Parser{tokens}.parse() }
+{
+    m_root->optimize();
+}
+
+Expression::Expression( Expression&& ) noexcept = default;
+Expression& Expression::operator=( Expression&& ) noexcept = default;
+Expression::~Expression() = default;
+
+auto Expression::operator()( string_view name, jam::DirectoryEntry& entry ) const -> bool
+{
+    return m_root->evaluate( name, entry );
+}
+
+auto Expression::to_string() const -> string
+{
+    return m_root->to_string();
+}
@@ -2,12 +2,16 @@
 #include <vector>
 #include <string>
 #include <algorithm>
-#include <regex>
 #include <utility>
+#include <memory>
+#include <stdexcept>
 #include <clara/clara.hpp>
 #include <boost/filesystem.hpp>
-
-#include <future>
+#include <jam/line_writer.hpp>
+#include "search.hpp"
+#include "expression.hpp"
+#include "path_index.hpp"
+#include "executor.hpp"
 
 namespace fs = boost::filesystem;
 
@@ -21,68 +25,165 @@ namespace
 {
 bool g_help_flag{false};
 string g_start_path;
-string g_name{};
-} // namespace
+unsigned g_jobs{0};
+bool g_unordered{false};
+size_t g_buffer_limit{Search::default_buffer_limit};
+bool g_show_tree{false};
+string g_build_index;
+string g_index;
+bool g_refresh{false};
+unsigned g_exec_jobs{1};
 
+// The words of an -exec up to its ';' or '+'
+struct ExecCommand
+{
+    vector<string> words;
+    Executor::Mode mode;
+};
 
-vector<string> parallel_find_name( const fs::path& p, const std::regex& re );
+const char* const expression_help =
+    "\nexpression:\n"
+    "  -name PATTERN, -iname PATTERN     shell pattern on the file name\n"
+    "  -regex REGEX                      regular expression searched for in the name\n"
+    "  -type [fdlbcps]                   kind of file, symbolic links not followed\n"
+    "  -size [+-]N[bckwMG]               size in units, 512 byte blocks by default\n"
+    "  -mtime [+-]N, -mmin [+-]N         modified N days / minutes ago\n"
+    "  -perm MODE, -perm -MODE, -perm /MODE\n"
+    "                                    octal permission bits - exact, all, any\n"
+    "  ( EXPR ), ! EXPR, -not EXPR, EXPR [-a|-and] EXPR, EXPR -o|-or EXPR\n"
+    "\nactions, after the expression - the matches are printed without one:\n"
+    "  -exec COMMAND ;                   run COMMAND for each match, {} is its path\n"
+    "  -exec COMMAND {} +                run COMMAND for as many matches at once as fit\n"
+    "\nindex:\n"
+    "  find --build-index DB PATH [--refresh]    write an index of the paths below PATH\n"
+    "  find --index DB [--refresh] [PATH] EXPR   search the index, below PATH if given\n";
+} // namespace
 
 
 int main( int argc, char* argv[] )
-{
+try{
+    // The expression words, in order and with their arguments, and the
+    // -exec actions are taken out before the options are parsed
+    vector<string> expression_tokens;
+    vector<ExecCommand> exec_commands;
+    vector<char*> option_args{ argv[0] };
+    for( int i = 1; i < argc; ++i ){
+        const auto word = string{argv[i]};
+        if( word == "-exec" || word == "--exec" ){
+            auto command = ExecCommand{ {}, Executor::Mode::each };
+            for( ++i; i < argc; ++i ){
+                const auto argument = string{argv[i]};
+                if( argument == ";" )
+                    break;
+                if( argument == "+" && !command.words.empty() && command.words.back() == "{}" ){
+                    command.mode = Executor::Mode::batch;
+                    break;
+                }
+                command.words.push_back( argument );
+            }
+            if( i == argc )
+                throw std::invalid_argument( "Expected ';' or '{} +' after -exec" );
+            exec_commands.push_back( std::move(command) );
+            continue;
+        }
+        const auto arguments = Expression::arguments( word );
+        if( arguments < 0 ){
+            option_args.push_back( argv[i] );
+            continue;
+        }
+        if( !exec_commands.empty() )
+            throw std::invalid_argument( "The expression goes before -exec, '" + word + "' is after it" );
+        expression_tokens.push_back( word );
+        for( int n = 0; n < arguments && i + 1 < argc; ++n )
+            expression_tokens.push_back( argv[++i] );
+    }
+
     auto clip
             = Arg( g_start_path, "Path where the search should begin" )
-            | Opt( g_name, "Something" )["--name"]
-                 ("File names to find")
+            | Opt( g_jobs, "N" )["-j"]["--jobs"]
+                 ("Number of worker threads, 0 for one per hardware thread")
+            | Opt( g_unordered )["--unordered"]
+                 ("Print matches as soon as they are found, in no particular order")
+            | Opt( g_buffer_limit, "N" )["--buffer-limit"]
+                 ("Matches and directories held back at most to keep directory order")
+            | Opt( g_show_tree )["--show-tree"]
+                 ("Print the expression in the order it is evaluated to stderr")
+            | Opt( g_exec_jobs, "N" )["-P"]["--max-procs"]
+                 ("Commands of -exec run at the same time")
+            | Opt( g_build_index, "DB" )["--build-index"]
+                 ("Crawl the path and write an index of it to DB")
+            | Opt( g_index, "DB" )["--index"]
+                 ("Search the index in DB instead of the file system")
+            | Opt( g_refresh )["--refresh"]
+                 ("Update the index first, reading only the directories that changed")
             | Help( g_help_flag );
-    auto clip_result = clip.parse( clara::Args(argc, argv) );
+    auto clip_result = clip.parse( clara::Args( static_cast<int>(option_args.size()), option_args.data() ) );
     if( !clip_result || g_help_flag ){
-        cout << clip;
+        cout << clip << expression_help;
         return 0;
     }
 
     fs::path start_path(g_start_path);
-    if( !is_directory(start_path) ){
-        cout << clip;
+    if( g_index.empty() && !is_directory(start_path) ){
+        cout << clip << expression_help;
         return 1;
     }
 
-    if( !g_name.empty() ){
-        std::regex re(g_name);
-        auto paths = parallel_find_name( start_path, re );
-        for( const auto& p : paths ){
-            cout << p << endl;
-        }
-        // for( const auto& de : fs::recursive_directory_iterator(start_path) )
-        // {
-        //     auto path = de.path();
-        //     if( is_regular_file(path)
-        //         && std::regex_search(path.filename().string(), re) )
-        //         std::cout << path.string() << endl;
-        // }
+    if( !g_build_index.empty() ){
+        if( !expression_tokens.empty() )
+            throw std::invalid_argument( "An index is built without an expression" );
+        const auto statistics = g_refresh && fs::exists( g_build_index )
+                              ? PathIndex::refresh( g_build_index, g_start_path )
+                              : PathIndex::build( g_build_index, g_start_path );
+        std::cerr << "find: indexed " << statistics.entries << " entries in "
+                  << statistics.directories << " directories, read " << statistics.read << endl;
+        return statistics.errors == 0 ? 0 : 1;
     }
-}
 
+    const Expression expression( expression_tokens );
+    if( g_show_tree )
+        std::cerr << expression.to_string() << endl;
+    const auto match = [&expression]( std::string_view name, jam::DirectoryEntry& entry ){
+        return expression( name, entry );
+    };
 
-vector<string> parallel_find_name( const fs::path& p, const std::regex& re )
-{
-    std::vector<std::future<std::vector<std::string>>> future_results;
-    std::vector<std::string> results;
-    for( const auto& de : fs::directory_iterator(p) )
-    {
-        auto path = de.path();
-        if(fs::is_directory(path)){
-            future_results.push_back(std::async(parallel_find_name, path, re));
-        }
-        else if( fs::is_regular_file(path)
-                    && std::regex_search(path.filename().string(), re) ){
-            results.push_back(path.string());
+    // The matches go straight from the walk to the commands of -exec, and
+    // are printed only without them
+    vector<std::unique_ptr<Executor>> executors;
+    for( auto& command : exec_commands ){
+        executors.push_back( std::make_unique<Executor>( std::move(command.words), command.mode, g_exec_jobs ) );
+    }
+    jam::LineWriter out;
+    const auto emit = [&out, &executors]( const string& path ){
+        if( executors.empty() )
+            out.write_line( path );
+        for( auto& executor : executors ){
+            executor->add( path );
         }
+    };
+
+    // Like find, errors on the way are reported and make the exit status 1,
+    // but the rest of the tree is still searched
+    auto succeeded = true;
+    if( !g_index.empty() ){
+        if( g_refresh )
+            succeeded = PathIndex::refresh( g_index ).errors == 0;
+        const PathIndex index( g_index );
+        succeeded = index.search( g_start_path, match, emit ) && succeeded;
+    }
+    else{
+        Search search( g_jobs, g_unordered ? Search::Order::unordered : Search::Order::directory,
+                       g_buffer_limit );
+        succeeded = search.run( start_path.string(), match, emit, [&out]{ out.flush(); } );
     }
-    for( auto& f : future_results ){
-        auto res = f.get();
-        for( auto&& s : res )
-            results.push_back(std::move(s));
+    out.flush();
+
+    for( auto& executor : executors ){
+        succeeded = executor->finish() && succeeded;
     }
-    return results;
+    return succeeded ? 0 : 1;
+}
+catch( const std::exception& e ){
+    std::cerr << e.what() << endl;
+    return 1;
 }
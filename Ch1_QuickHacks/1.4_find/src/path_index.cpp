@@ -0,0 +1,458 @@
+#include "path_index.hpp"
+#include <jam/directory_reader.hpp>
+#include <boost/filesystem.hpp>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = boost::filesystem;
+
+using std::string; using std::string_view; using std::vector;
+
+
+namespace
+{
+constexpr char index_magic[8] = { 'J', 'A', 'M', 'P', 'A', 'T', 'H', '1' };
+constexpr std::size_t flush_size{1 << 20};
+
+// Written in the byte order of the machine, the root path follows it
+struct Header
+{
+    char magic[8];
+    std::uint64_t directories;
+    std::uint64_t entries;
+    std::uint64_t root_size;
+};
+
+void report( const string& what )
+{
+    std::cerr << "find: " << what << '\n';
+}
+
+auto system_error( const string& what, const string& name ) -> std::runtime_error
+{
+    return std::runtime_error( what + " " + name + ": " + std::strerror(errno) );
+}
+
+// The path of an entry of directory
+auto join( const string& directory, string_view name ) -> string
+{
+    auto path = directory;
+    if( path.empty() || path.back() != '/' )
+        path += '/';
+    path += name;
+    return path;
+}
+
+// The absolute path without "." and ".." in it, the way it is indexed
+auto normalise( const string& path ) -> string
+{
+    auto normal = fs::absolute( path ).lexically_normal().string();
+    // A trailing separator comes back as "/."
+    while( normal.size() > 1 && normal.compare(normal.size() - 2, 2, "/.") == 0 )
+        normal.resize( normal.size() == 2 ? 1 : normal.size() - 2 );
+    return normal;
+}
+
+// Whether directory is under, or below it
+auto is_below( string_view directory, string_view under ) noexcept -> bool
+{
+    while( under.size() > 1 && under.back() == '/' )
+        under.remove_suffix(1);
+    if( under.empty() || directory == under )
+        return true;
+    return directory.substr(0, under.size()) == under
+        && (under == "/" || directory.size() == under.size() || directory[under.size()] == '/');
+}
+
+
+/* Encoding */
+/* ------------------------------------------------------------------------- */
+void put_varint( string& out, std::uint64_t value )
+{
+    while( value >= 0x80 ){
+        out += static_cast<char>( (value & 0x7f) | 0x80 );
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void put_front_coded( string& out, string_view previous, string_view text )
+{
+    const auto limit = std::min( previous.size(), text.size() );
+    auto shared = std::size_t{0};
+    while( shared < limit && previous[shared] == text[shared] )
+        ++shared;
+    put_varint( out, shared );
+    put_varint( out, text.size() - shared );
+    out.append( text.substr(shared) );
+}
+
+// Reads the records of a mapped index. Throws std::runtime_error when one
+// reaches past the end.
+class Decoder
+{
+public:
+    Decoder( const char* begin, const char* end ) noexcept
+        : m_pos{begin}, m_end{end}
+        { }
+
+    auto at_end() const noexcept -> bool { return m_pos == m_end; }
+    auto position() const noexcept -> const char* { return m_pos; }
+
+    auto varint() -> std::uint64_t
+    {
+        auto value = std::uint64_t{0};
+        for( unsigned shift = 0; shift < 64; shift += 7 ){
+            if( m_pos == m_end )
+                break;
+            const auto byte = static_cast<unsigned char>(*m_pos++);
+            value |= std::uint64_t{byte & 0x7fu} << shift;
+            if( (byte & 0x80) == 0 )
+                return value;
+        }
+        damaged();
+    }
+
+    auto entry_type() -> jam::EntryType
+    {
+        if( m_pos == m_end || static_cast<unsigned char>(*m_pos) > static_cast<unsigned char>(jam::EntryType::other) )
+            damaged();
+        return static_cast<jam::EntryType>(*m_pos++);
+    }
+
+    // Replaces what follows text[0, base) by the next front-coded string
+    void front_coded( string& text, std::size_t base = 0 )
+    {
+        const auto shared = varint();
+        const auto rest = varint();
+        if( shared > text.size() - base || rest > static_cast<std::size_t>(m_end - m_pos) )
+            damaged();
+        text.resize( base + shared );
+        text.append( m_pos, rest );
+        m_pos += rest;
+    }
+
+    void skip( std::uint64_t size )
+    {
+        if( size > static_cast<std::size_t>(m_end - m_pos) )
+            damaged();
+        m_pos += size;
+    }
+
+private:
+    [[noreturn]] static void damaged()
+    {
+        throw std::runtime_error( "The index is damaged" );
+    }
+
+    const char* m_pos;
+    const char* m_end;
+};
+
+// A directory record up to its entries, which follow at the decoder's position
+struct Record
+{
+    std::int64_t seconds;
+    std::int64_t nanoseconds;
+    std::uint64_t count;
+    std::uint64_t size;
+};
+
+auto read_record( Decoder& decoder, string& path ) -> Record
+{
+    decoder.front_coded( path );
+    auto record = Record{};
+    record.seconds = static_cast<std::int64_t>( decoder.varint() );
+    record.nanoseconds = static_cast<std::int64_t>( decoder.varint() );
+    record.count = decoder.varint();
+    record.size = decoder.varint();
+    return record;
+}
+/* ------------------------------------------------------------------------- */
+} // namespace
+
+
+/* Building */
+/* ------------------------------------------------------------------------- */
+// Writes an index to a temporary file next to the database and renames it
+// over the database when it is complete. With an old index the directories
+// whose mtime did not change are taken from it instead of being read.
+class PathIndex::Builder
+{
+public:
+    Builder( const string& db, const PathIndex* old )
+        : m_db{db}
+        , m_temporary{db + ".tmp"}
+    {
+        if( old == nullptr )
+            return;
+        auto decoder = Decoder{ old->m_data + old->m_records, old->m_data + old->m_size };
+        for( auto path = string{}; !decoder.at_end(); ){
+            const auto record = read_record( decoder, path );
+            m_known.emplace( path, Known{ record, decoder.position() } );
+            decoder.skip( record.size );
+        }
+    }
+
+    Builder( const Builder& ) = delete;
+    Builder& operator=( const Builder& ) = delete;
+
+    ~Builder()
+    {
+        if( m_fd != -1 ){
+            ::close( m_fd );
+            ::unlink( m_temporary.c_str() );
+        }
+    }
+
+    auto run( const string& root ) -> Statistics
+    {
+        m_fd = ::open( m_temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+        if( m_fd == -1 )
+            throw system_error( "Failed to create", m_temporary );
+
+        m_out.assign( sizeof(Header), '\0' );
+        m_out += root;
+        visit( root );
+        flush();
+
+        auto header = Header{};
+        std::memcpy( header.magic, index_magic, sizeof(index_magic) );
+        header.directories = m_statistics.directories;
+        header.entries = m_statistics.entries;
+        header.root_size = root.size();
+        if( ::pwrite(m_fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) )
+            throw system_error( "Failed to write", m_temporary );
+        const auto fd = std::exchange( m_fd, -1 );
+        if( ::close(fd) == -1 || ::rename(m_temporary.c_str(), m_db.c_str()) == -1 ){
+            const auto error = system_error( "Failed to write", m_db );
+            ::unlink( m_temporary.c_str() );
+            throw error;
+        }
+        return m_statistics;
+    }
+
+private:
+    struct Known
+    {
+        Record record;
+        const char* entries;
+    };
+
+    void visit( const string& path )
+    {
+        struct stat status{};
+        if( ::stat(path.c_str(), &status) == -1 ){
+            report( system_error("Failed to stat", path).what() );
+            ++m_statistics.errors;
+            return;
+        }
+
+        if( const auto known = m_known.find(path);
+            known != m_known.end()
+            && known->second.record.seconds == status.st_mtim.tv_sec
+            && known->second.record.nanoseconds == status.st_mtim.tv_nsec ){
+            const auto& record = known->second.record;
+            const auto entries = known->second.entries;
+            write_record( path, status, record.count, string_view{ entries, record.size } );
+
+            auto decoder = Decoder{ entries, entries + record.size };
+            auto child = join( path, {} );
+            const auto base = child.size();
+            for( auto n = record.count; n != 0; --n ){
+                const auto type = decoder.entry_type();
+                decoder.front_coded( child, base );
+                if( type == jam::EntryType::directory )
+                    visit( child );
+            }
+            return;
+        }
+
+        auto listing = vector<std::pair<string, jam::EntryType>>{};
+        try{
+            auto reader = jam::DirectoryReader{ path };
+            for( auto entry = jam::DirectoryEntry{}; reader.next(entry); ){
+                listing.emplace_back( entry.name(), entry.type() );
+            }
+        }
+        catch( const std::runtime_error& e ){
+            report( e.what() );
+            ++m_statistics.errors;
+            return;
+        }
+        std::sort( listing.begin(), listing.end() );
+
+        auto entries = string{};
+        auto previous = string_view{};
+        for( const auto& [name, type] : listing ){
+            entries += static_cast<char>(type);
+            put_front_coded( entries, previous, name );
+            previous = name;
+        }
+        write_record( path, status, listing.size(), entries );
+        ++m_statistics.read;
+
+        for( const auto& [name, type] : listing ){
+            if( type == jam::EntryType::directory )
+                visit( join(path, name) );
+        }
+    }
+
+    void write_record( const string& path, const struct stat& status,
+                       std::uint64_t count, string_view entries )
+    {
+        put_front_coded( m_out, m_previous, path );
+        m_previous = path;
+        put_varint( m_out, static_cast<std::uint64_t>(status.st_mtim.tv_sec) );
+        put_varint( m_out, static_cast<std::uint64_t>(status.st_mtim.tv_nsec) );
+        put_varint( m_out, count );
+        put_varint( m_out, entries.size() );
+        m_out.append( entries );
+
+        ++m_statistics.directories;
+        m_statistics.entries += count;
+        if( m_out.size() >= flush_size )
+            flush();
+    }
+
+    void flush()
+    {
+        for( auto data = m_out.data(), end = data + m_out.size(); data != end; ){
+            const auto written = ::write( m_fd, data, static_cast<std::size_t>(end - data) );
+            if( written == -1 ){
+                if( errno == EINTR )
+                    continue;
+                throw system_error( "Failed to write", m_temporary );
+            }
+            data += written;
+        }
+        m_out.clear();
+    }
+
+    string m_db;
+    string m_temporary;
+    int m_fd{-1};
+    std::unordered_map<string, Known> m_known{};
+    string m_out{};
+    string m_previous{};
+    Statistics m_statistics{};
+};
+
+
+auto PathIndex::build( const string& db, const string& root ) -> Statistics
+{
+    auto builder = Builder{ db, nullptr };
+    return builder.run( normalise(root) );
+}
+
+auto PathIndex::refresh( const string& db, const string& root ) -> Statistics
+{
+    // The old index stays mapped until the new one is written
+    const auto old = PathIndex{ db };
+    auto builder = Builder{ db, &old };
+    return builder.run( root.empty() ? old.root() : normalise(root) );
+}
+/* ------------------------------------------------------------------------- */
+
+
+/* Searching */
+/* ------------------------------------------------------------------------- */
+PathIndex::PathIndex( const string& db )
+{
+    const auto fd = ::open( db.c_str(), O_RDONLY | O_CLOEXEC );
+    if( fd == -1 )
+        throw system_error( "Failed to open the index", db );
+    struct stat status{};
+    if( ::fstat(fd, &status) == -1 ){
+        const auto error = system_error( "Failed to stat", db );
+        ::close( fd );
+        throw error;
+    }
+    const auto size = static_cast<std::size_t>(status.st_size);
+    auto* data = size < sizeof(Header) ? MAP_FAILED
+                                       : ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd );
+    if( data == MAP_FAILED )
+        throw std::runtime_error( db + " is no index" );
+
+    auto header = Header{};
+    std::memcpy( &header, data, sizeof(header) );
+    if( std::memcmp(header.magic, index_magic, sizeof(index_magic)) != 0
+        || header.root_size > size - sizeof(header) ){
+        ::munmap( data, size );
+        throw std::runtime_error( db + " is no index" );
+    }
+    // A search reads the whole mapping front to back
+    ::madvise( data, size, MADV_SEQUENTIAL );
+
+    m_data = static_cast<const char*>(data);
+    m_size = size;
+    m_root.assign( m_data + sizeof(header), header.root_size );
+    m_directories = header.directories;
+    m_entries = header.entries;
+    m_records = sizeof(header) + header.root_size;
+}
+
+PathIndex::~PathIndex()
+{
+    ::munmap( const_cast<char*>(m_data), m_size );
+}
+
+auto PathIndex::search( const string& under, const Search::Predicate& match,
+                        const Search::Emit& emit ) const -> bool
+{
+    // Anything above the root takes in the whole index, anything beside it
+    // would silently find nothing
+    const auto start = under.empty() ? string{} : normalise( under );
+    if( !is_below(start, m_root) && !is_below(m_root, start) )
+        throw std::runtime_error( under + " is not in the index of " + m_root );
+
+    auto succeeded = true;
+    auto decoder = Decoder{ m_data + m_records, m_data + m_size };
+    auto directory = string{};
+    auto path = string{};
+    while( !decoder.at_end() ){
+        const auto record = read_record( decoder, directory );
+        if( !is_below(directory, start) ){
+            decoder.skip( record.size );
+            continue;
+        }
+
+        // Each name is decoded right behind the directory, so the path is
+        // ready to be stat'ed and emitted
+        path.assign( directory );
+        if( path.empty() || path.back() != '/' )
+            path += '/';
+        const auto base = path.size();
+        for( auto n = record.count; n != 0; --n ){
+            const auto type = decoder.entry_type();
+            decoder.front_coded( path, base );
+            auto matched = false;
+            try{
+                auto entry = jam::DirectoryEntry{ AT_FDCWD, path, type };
+                matched = match( string_view{path}.substr(base), entry );
+            }
+            catch( const std::runtime_error& e ){
+                // Gone since the index was built
+                report( e.what() );
+                succeeded = false;
+            }
+            if( matched )
+                emit( path );
+        }
+    }
+    return succeeded;
+}
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,308 @@
+#include "search.hpp"
+#include <jam/work_stealing_pool.hpp>
+#include <jam/mpsc_queue.hpp>
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+
+using std::string; using std::vector;
+
+
+namespace
+{
+std::mutex g_stderr_mutex;
+
+void report( const char* what, std::atomic<bool>& failed )
+{
+    failed = true;
+    std::lock_guard<std::mutex> lock(g_stderr_mutex);
+    std::cerr << "find: " << what << '\n';
+}
+
+// Reads one directory with getdents64, taking the entry types from d_type, so
+// only the entries of filesystems without d_type - or the ones a predicate
+// asks the status of - get stat'ed. The path of every entry is put together
+// in one buffer, and copied only for matches and subdirectories.
+// An entry that cannot be stat'ed, gone or not accessible, is reported and
+// does not match; the rest of the directory is still read.
+template<typename OnMatch, typename OnSubdirectory>
+void read_directory( string path, const Search::Predicate& match, std::atomic<bool>& failed,
+                     OnMatch on_match, OnSubdirectory on_subdirectory )
+{
+    try{
+        jam::DirectoryReader directory( path );
+        if( path.empty() || path.back() != '/' )
+            path += '/';
+        const auto directory_size = path.size();
+
+        for( auto entry = jam::DirectoryEntry{}; directory.next( entry ); ){
+            const auto name = entry.name();
+            auto matched = false;
+            auto is_directory = false;
+            try{
+                matched = match( name, entry );
+                is_directory = entry.type() == jam::EntryType::directory;
+            }
+            catch( const std::runtime_error& e ){
+                report( e.what(), failed );
+            }
+            if( matched || is_directory ){
+                path.resize( directory_size );
+                path += name;
+            }
+            if( matched )
+                on_match( path );
+            if( is_directory )
+                on_subdirectory( path );
+        }
+    }
+    catch( const std::runtime_error& e ){
+        report( e.what(), failed );
+    }
+}
+
+// For destructors - an error of the walk was either rethrown already or is
+// dropped in favour of the one that is on its way out
+void wait_quietly( jam::WorkStealingPool& pool ) noexcept
+{
+    try{
+        pool.wait();
+    }
+    catch( ... ){
+    }
+}
+
+
+// A directory of the ordered walk - its matches wait here until everything
+// before them was emitted
+struct Node
+{
+    enum State { waiting, claimed, done };
+
+    explicit Node( string directory ) : path{std::move(directory)} { }
+
+    string path;
+    std::atomic<int> state{waiting};
+    vector<string> matches{};
+    vector<std::shared_ptr<Node>> children{};
+};
+
+class OrderedWalk
+{
+public:
+    OrderedWalk( unsigned jobs, std::size_t buffer_limit, const Search::Predicate& match )
+        : m_buffer_limit{buffer_limit}
+        , m_match{match}
+        , m_pool{jobs}
+        { }
+
+    ~OrderedWalk()
+    {
+        stop();
+        wait_quietly( m_pool );
+    }
+
+    auto run( const string& root, const Search::Emit& emit, const Search::Idle& idle ) -> bool
+    {
+        auto node = std::make_shared<Node>( root );
+        emit_node( *node, emit, idle );
+        m_pool.wait();
+        return !m_failed;
+    }
+
+private:
+    static auto claim( Node& node ) -> bool
+    {
+        auto expected = static_cast<int>(Node::waiting);
+        return node.state.compare_exchange_strong( expected, Node::claimed );
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_changed.notify_all();
+    }
+
+    void process( Node& node )
+    {
+        read_directory( node.path, m_match, m_failed,
+            [&]( const string& path ){
+                node.matches.push_back( path );
+            },
+            [&]( const string& path ){
+                node.children.push_back( std::make_shared<Node>(path) );
+                m_pool.submit( [this, child = node.children.back()]{ visit(child); } );
+            });
+        // Every child node holds its path and a task of the pool until it is
+        // emitted - in a wide tree those add up as much as the matches
+        m_buffered.fetch_add( node.matches.size() + node.children.size() );
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            node.state = Node::done;
+        }
+        m_changed.notify_all();
+    }
+
+    // Runs on the pool. Holds back while too many matches and directories are
+    // buffered - the emitting thread reads the directory itself when it gets
+    // there first.
+    void visit( const std::shared_ptr<Node>& node )
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait( lock, [&]{
+                return m_stopped || m_buffered < m_buffer_limit || node->state != Node::waiting;
+            });
+            if( m_stopped )
+                return;
+        }
+        if( claim(*node) )
+            process( *node );
+    }
+
+    void emit_node( Node& node, const Search::Emit& emit, const Search::Idle& idle )
+    {
+        // Whatever was emitted so far can go out while this node is read
+        if( claim(node) ){
+            idle();
+            process( node );
+        }
+        else if( node.state != Node::done ){
+            idle();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait( lock, [&]{ return node.state == Node::done; } );
+        }
+
+        try{
+            for( const auto& path : node.matches )
+                emit( path );
+        }
+        catch( ... ){
+            stop();
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_buffered -= node.matches.size();
+        }
+        m_changed.notify_all();
+        vector<string>{}.swap( node.matches );
+
+        for( auto& child : node.children ){
+            emit_node( *child, emit, idle );
+            child.reset();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                --m_buffered;
+            }
+            m_changed.notify_all();
+        }
+    }
+
+    std::size_t m_buffer_limit;
+    const Search::Predicate& m_match;
+    // Matches and directories found but not emitted yet
+    std::atomic<std::size_t> m_buffered{0};
+    std::mutex m_mutex{};
+    std::condition_variable m_changed{};
+    bool m_stopped{false};
+    std::atomic<bool> m_failed{false};
+    // Last, so the workers are gone before anything they use
+    jam::WorkStealingPool m_pool;
+};
+
+
+class UnorderedWalk
+{
+public:
+    UnorderedWalk( unsigned jobs, const Search::Predicate& match )
+        : m_match{match}
+        , m_pool{jobs}
+        { }
+
+    ~UnorderedWalk()
+    {
+        m_stopped = true;
+        wait_quietly( m_pool );
+    }
+
+    auto run( const string& root, const Search::Emit& emit, const Search::Idle& idle ) -> bool
+    {
+        m_pending = 1;
+        m_pool.submit( [this, root]{ visit(root); } );
+
+        // Nothing to wait on without a lock - back off from polling the queue
+        // while it stays empty, up to a millisecond
+        auto backoff = std::chrono::microseconds{1};
+        for( ;; ){
+            // Read first: whatever was found before the walk ended is queued
+            const auto finished = m_pending == 0;
+            if( m_matches.consume(emit) != 0 ){
+                backoff = std::chrono::microseconds{1};
+                continue;
+            }
+            if( finished )
+                break;
+            idle();
+            std::this_thread::sleep_for( backoff );
+            backoff = std::min( backoff * 2, std::chrono::microseconds{1000} );
+        }
+        m_pool.wait();
+        return !m_failed;
+    }
+
+private:
+    void visit( const string& path )
+    {
+        if( !m_stopped ){
+            read_directory( path, m_match, m_failed,
+                [this]( const string& match_path ){
+                    m_matches.push( match_path );
+                },
+                [this]( const string& subdirectory ){
+                    m_pending.fetch_add( 1 );
+                    m_pool.submit( [this, subdirectory]{ visit(subdirectory); } );
+                });
+        }
+        m_pending.fetch_sub( 1 );
+    }
+
+    const Search::Predicate& m_match;
+    jam::MpscQueue<string> m_matches{};
+    // Directories queued or being read
+    std::atomic<std::size_t> m_pending{0};
+    std::atomic<bool> m_stopped{false};
+    std::atomic<bool> m_failed{false};
+    // Last, so the workers are gone before anything they use
+    jam::WorkStealingPool m_pool;
+};
+} // namespace
+
+
+Search::Search( unsigned jobs, Order order, std::size_t buffer_limit )
+    : m_jobs{jobs}
+    , m_order{order}
+    , m_buffer_limit{ std::max<std::size_t>(buffer_limit, 1) }
+{
+}
+
+auto Search::run( const string& root, const Predicate& match, const Emit& emit, const Idle& idle ) -> bool
+{
+    if( m_order == Order::directory ){
+        OrderedWalk walk( m_jobs, m_buffer_limit, match );
+        return walk.run( root, emit, idle );
+    }
+
+    UnorderedWalk walk( m_jobs, match );
+    return walk.run( root, emit, idle );
+}
@@ -0,0 +1,156 @@
+#include "catch/catch.hpp"
+#include "executor.hpp"
+#include <jam/external_sort.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+auto read_lines( const std::string& fname ) -> std::vector<std::string>
+{
+    auto ifs = std::ifstream{fname};
+    auto lines = std::vector<std::string>{};
+    for( std::string line; std::getline(ifs, line); ){
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// The number of paths every command was run with, one per invocation
+auto argument_counts( const std::string& fname ) -> std::vector<std::size_t>
+{
+    auto counts = std::vector<std::size_t>{};
+    for( const auto& line : read_lines(fname) ){
+        counts.push_back( std::stoul(line) );
+    }
+    return counts;
+}
+} // namespace
+
+
+TEST_CASE( "Executor runs a command per path or in batches" )
+{
+    SECTION( "a command per path succeeds whatever it returns" ){
+        auto executor = Executor{ { "sh", "-c", "exit 1", "sh", "{}" }, Executor::Mode::each, 2 };
+        for( int i = 0; i != 5; ++i ){
+            executor.add( "path" + std::to_string(i) );
+        }
+        REQUIRE( executor.finish() );
+    }
+
+    SECTION( "a failed batch fails" ){
+        auto executor = Executor{ { "false", "{}" }, Executor::Mode::batch };
+        executor.add( "path" );
+        REQUIRE_FALSE( executor.finish() );
+    }
+
+    SECTION( "a command that cannot be run fails" ){
+        auto executor = Executor{ { "jam-no-such-command", "{}" }, Executor::Mode::each };
+        executor.add( "path" );
+        REQUIRE_FALSE( executor.finish() );
+    }
+
+    SECTION( "errors" ){
+        REQUIRE_THROWS_AS( (Executor{ {}, Executor::Mode::each }), std::invalid_argument );
+        REQUIRE_THROWS_AS( (Executor{ { "echo", "{}", "x" }, Executor::Mode::batch }), std::invalid_argument );
+    }
+}
+
+TEST_CASE( "Executor packs paths into as few commands as fit" )
+{
+    auto log = jam::TemporaryFile{};
+    const auto count_arguments = std::vector<std::string>{
+        "sh", "-c", "echo $# >> " + log.path(), "sh", "{}" };
+
+    SECTION( "short paths go into a single command" ){
+        auto executor = Executor{ count_arguments, Executor::Mode::batch };
+        for( int i = 0; i != 100; ++i ){
+            executor.add( "path" + std::to_string(i) );
+        }
+        REQUIRE( executor.finish() );
+        REQUIRE( argument_counts(log.path()) == std::vector<std::size_t>{100} );
+    }
+
+    SECTION( "nothing is run without paths" ){
+        auto executor = Executor{ count_arguments, Executor::Mode::batch };
+        REQUIRE( executor.finish() );
+        REQUIRE( argument_counts(log.path()).empty() );
+    }
+
+    SECTION( "paths past ARG_MAX split the batch" ){
+        // Every path well below the limit of a single argument, all of them
+        // together several times ARG_MAX
+        const auto long_path = std::string(100000, 'x');
+        constexpr std::size_t paths{100};
+        auto executor = Executor{ count_arguments, Executor::Mode::batch };
+        for( std::size_t i = 0; i != paths; ++i ){
+            executor.add( long_path );
+        }
+        REQUIRE( executor.finish() );
+
+        const auto counts = argument_counts(log.path());
+        REQUIRE( counts.size() > 1 );
+        REQUIRE( std::accumulate(counts.begin(), counts.end(), std::size_t{0}) == paths );
+        // Full commands but for the last one
+        for( std::size_t i = 0; i + 1 < counts.size(); ++i ){
+            REQUIRE( counts[i] == counts.front() );
+            REQUIRE( counts[i] > 1 );
+        }
+        REQUIRE( counts.back() <= counts.front() );
+    }
+}
+
+TEST_CASE( "Executor replaces {} wherever it occurs for each path" )
+{
+    auto log = jam::TemporaryFile{};
+    auto executor = Executor{ { "sh", "-c", "echo \"$1\" >> " + log.path(), "sh", "<{}|{}>" },
+                              Executor::Mode::each };
+    executor.add( "a" );
+    executor.add( "b c" );
+    REQUIRE( executor.finish() );
+    REQUIRE( read_lines(log.path()) == std::vector<std::string>{ "<a|a>", "<b c|b c>" } );
+}
+
+TEST_CASE( "Executor runs at most jobs commands at a time" )
+{
+    // Every command logs its start and its end - the running ones can be
+    // counted from the order of the lines
+    auto log = jam::TemporaryFile{};
+    auto executor = Executor{
+        { "sh", "-c", "echo + >> " + log.path() + "; sleep 0.2; echo - >> " + log.path(), "sh", "{}" },
+        Executor::Mode::each, 2 };
+    for( int i = 0; i != 6; ++i ){
+        executor.add( "path" + std::to_string(i) );
+    }
+    REQUIRE( executor.finish() );
+
+    const auto lines = read_lines(log.path());
+    REQUIRE( lines.size() == 12 );
+    auto running = 0;
+    auto most_running = 0;
+    for( const auto& line : lines ){
+        running += line == "+" ? 1 : -1;
+        most_running = std::max(most_running, running);
+    }
+    REQUIRE( running == 0 );
+    REQUIRE( most_running == 2 );
+}
+
+TEST_CASE( "Executors wait only for their own commands" )
+{
+    // Two -exec actions - the commands of the first have ended, unreaped,
+    // while the failing batch of the second is waited for
+    auto each = Executor{ { "true", "{}" }, Executor::Mode::each, 4 };
+    auto batch = Executor{ { "sh", "-c", "sleep 0.2; exit 1", "sh", "{}" }, Executor::Mode::batch };
+    for( int i = 0; i != 4; ++i ){
+        const auto path = "path" + std::to_string(i);
+        each.add( path );
+        batch.add( path );
+    }
+    REQUIRE_FALSE( batch.finish() );
+    REQUIRE( each.finish() );
+}
@@ -0,0 +1,234 @@
+#include "catch/catch.hpp"
+#include "expression.hpp"
+#include "temporary_directory.hpp"
+#include <jam/directory_reader.hpp>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <regex>
+#include <stdexcept>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+using Tokens = std::vector<std::string>;
+using Names = std::set<std::string>;
+
+namespace
+{
+void make_file( const fs::path& path, std::size_t size, std::time_t age = 0 )
+{
+    std::ofstream{ path } << std::string( size, 'x' );
+    if( age != 0 ){
+        const auto then = std::time(nullptr) - age;
+        const struct timespec times[2] = { { then, 0 }, { then, 0 } };
+        REQUIRE( ::utimensat( AT_FDCWD, path.c_str(), times, 0 ) == 0 );
+    }
+}
+
+// The value of the expression for each entry of directory
+auto evaluate( const Tokens& tokens, const fs::path& directory ) -> std::map<std::string, bool>
+{
+    const auto expression = Expression{ tokens };
+    auto results = std::map<std::string, bool>{};
+    auto reader = jam::DirectoryReader{ directory.string() };
+    for( auto entry = jam::DirectoryEntry{}; reader.next(entry); ){
+        const auto name = std::string{ entry.name() };
+        results[name] = expression( name, entry );
+    }
+    return results;
+}
+
+// The names of the entries of directory the expression holds for
+auto matching( const Tokens& tokens, const fs::path& directory ) -> Names
+{
+    auto names = Names{};
+    for( const auto& [name, matched] : evaluate(tokens, directory) ){
+        if( matched )
+            names.insert( name );
+    }
+    return names;
+}
+} // namespace
+
+
+TEST_CASE( "Expression rejects what find rejects" )
+{
+    const auto error = []( const Tokens& tokens, const char* message ){
+        REQUIRE_THROWS_WITH( Expression{ tokens }, Catch::Contains(message) );
+    };
+    error( { "-name" }, "Expected more of the expression after '-name'" );
+    error( { "-name", "x", "-o" }, "Expected more of the expression" );
+    error( { "!" }, "Expected more of the expression" );
+    error( { "(", "-name", "x" }, "Expected ')'" );
+    error( { ")" }, "Unexpected ')'" );
+    error( { "-name", "x", ")" }, "Unexpected ')'" );
+    error( { "-o", "-name", "x" }, "Unexpected '-o'" );
+    error( { "-name", "x", "-bogus" }, "Unexpected '-bogus'" );
+    error( { "-type", "q" }, "Unknown type 'q'" );
+    error( { "-type", "fd" }, "Invalid argument 'fd'" );
+    error( { "-size", "1x" }, "Invalid unit 'x'" );
+    error( { "-size", "k" }, "Invalid argument 'k'" );
+    error( { "-mtime", "1k" }, "Invalid argument '1k'" );
+    error( { "-mmin", "+" }, "Invalid argument" );
+    error( { "-perm", "u+x" }, "only octal modes" );
+    error( { "-perm", "17777" }, "only octal modes" );
+    REQUIRE_THROWS_AS( (Expression{ Tokens{ "-regex", "(" } }), std::regex_error );
+
+    REQUIRE( Expression::arguments("-name") == 1 );
+    REQUIRE( Expression::arguments("--regex") == 1 );
+    REQUIRE( Expression::arguments("-perm") == 1 );
+    REQUIRE( Expression::arguments("!") == 0 );
+    REQUIRE( Expression::arguments("(") == 0 );
+    REQUIRE( Expression::arguments("-j") == -1 );
+    REQUIRE( Expression::arguments("path") == -1 );
+}
+
+TEST_CASE( "Expression tests entries like find" )
+{
+    auto directory = TemporaryDirectory{ "find_test_expression" };
+    const auto& root = directory.path();
+    make_file( root / "empty", 0 );
+    make_file( root / "small.txt", 1 );
+    make_file( root / "big.txt", 1025 );
+    make_file( root / "old.log", 10, 25 * 60 * 60 );
+    make_file( root / "recent.log", 10, 30 * 60 + 10 );
+    fs::create_directory( root / "dir" );
+    fs::create_symlink( "small.txt", root / "link" );
+    REQUIRE( ::mkfifo( (root / "fifo").c_str(), 0600 ) == 0 );
+    fs::permissions( root / "empty", fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read );
+
+    const auto match = [&root]( const Tokens& tokens ){ return matching( tokens, root ); };
+    const auto all_files = Names{ "empty", "small.txt", "big.txt", "old.log", "recent.log" };
+
+    SECTION( "an empty expression matches everything" ){
+        REQUIRE( match({}).size() == 8 );
+        REQUIRE( Expression{ {} }.to_string() == "-true" );
+    }
+
+    SECTION( "names" ){
+        REQUIRE( match({ "-name", "*.txt" }) == Names{ "small.txt", "big.txt" } );
+        REQUIRE( match({ "--name", "*.txt" }) == Names{ "small.txt", "big.txt" } );
+        REQUIRE( match({ "-name", "*.TXT" }).empty() );
+        REQUIRE( match({ "-iname", "*.TXT" }) == Names{ "small.txt", "big.txt" } );
+        REQUIRE( match({ "-regex", "^[a-z]+\\.log$" }) == Names{ "old.log", "recent.log" } );
+        // Searched for, not matched against the whole name
+        REQUIRE( match({ "-regex", "ig" }) == Names{ "big.txt" } );
+    }
+
+    SECTION( "types, symbolic links not followed" ){
+        REQUIRE( match({ "-type", "f" }) == all_files );
+        REQUIRE( match({ "-type", "d" }) == Names{ "dir" } );
+        REQUIRE( match({ "-type", "l" }) == Names{ "link" } );
+        REQUIRE( match({ "-type", "p" }) == Names{ "fifo" } );
+        REQUIRE( match({ "-type", "s" }).empty() );
+        REQUIRE( match({ "-type", "b" }).empty() );
+    }
+
+    SECTION( "sizes are rounded up to whole units" ){
+        REQUIRE( match({ "-type", "f", "-size", "0" }) == Names{ "empty" } );
+        REQUIRE( match({ "-type", "f", "-size", "-1" }) == Names{ "empty" } );
+        REQUIRE( match({ "-type", "f", "-size", "1" }) == Names{ "small.txt", "old.log", "recent.log" } );
+        REQUIRE( match({ "-type", "f", "-size", "3b" }) == Names{ "big.txt" } );
+        REQUIRE( match({ "-type", "f", "-size", "+2" }) == Names{ "big.txt" } );
+        REQUIRE( match({ "-type", "f", "-size", "1k" }) == Names{ "small.txt", "old.log", "recent.log" } );
+        REQUIRE( match({ "-type", "f", "-size", "2k" }) == Names{ "big.txt" } );
+        REQUIRE( match({ "-type", "f", "-size", "+1k" }) == Names{ "big.txt" } );
+        REQUIRE( match({ "-type", "f", "-size", "1025c" }) == Names{ "big.txt" } );
+        REQUIRE( match({ "-type", "f", "-size", "-2c" }) == Names{ "empty", "small.txt" } );
+        REQUIRE( match({ "-type", "f", "-size", "513w" }) == Names{ "big.txt" } );
+        REQUIRE( match({ "-type", "f", "-size", "1M" }) == Names{ "small.txt", "big.txt", "old.log", "recent.log" } );
+        REQUIRE( match({ "-type", "f", "-size", "-1G" }) == Names{ "empty" } );
+    }
+
+    SECTION( "ages are counted in whole periods, the rest dropped" ){
+        REQUIRE( match({ "-type", "f", "-mtime", "1" }) == Names{ "old.log" } );
+        REQUIRE( match({ "-type", "f", "-mtime", "+0" }) == Names{ "old.log" } );
+        REQUIRE( match({ "-type", "f", "-mtime", "0" }) == Names{ "empty", "small.txt", "big.txt", "recent.log" } );
+        REQUIRE( match({ "-type", "f", "-mtime", "-1" }) == Names{ "empty", "small.txt", "big.txt", "recent.log" } );
+        REQUIRE( match({ "-type", "f", "-mtime", "+1" }).empty() );
+        REQUIRE( match({ "-type", "f", "-mmin", "30" }) == Names{ "recent.log" } );
+        REQUIRE( match({ "-type", "f", "-mmin", "+29" }) == Names{ "old.log", "recent.log" } );
+        REQUIRE( match({ "-type", "f", "-mmin", "-30" }) == Names{ "empty", "small.txt", "big.txt" } );
+        REQUIRE( match({ "-type", "f", "-mmin", "1500" }) == Names{ "old.log" } );
+    }
+
+    SECTION( "permissions, exact, all of or any of the bits" ){
+        REQUIRE( match({ "-name", "empty", "-perm", "640" }) == Names{ "empty" } );
+        REQUIRE( match({ "-name", "empty", "-perm", "0640" }) == Names{ "empty" } );
+        REQUIRE( match({ "-name", "empty", "-perm", "600" }).empty() );
+        REQUIRE( match({ "-name", "empty", "-perm", "-600" }) == Names{ "empty" } );
+        REQUIRE( match({ "-name", "empty", "-perm", "-604" }).empty() );
+        REQUIRE( match({ "-name", "empty", "-perm", "/044" }) == Names{ "empty" } );
+        REQUIRE( match({ "-name", "empty", "-perm", "/004" }).empty() );
+        REQUIRE( match({ "-name", "empty", "-perm", "/0" }) == Names{ "empty" } );
+    }
+
+    SECTION( "! binds tighter than -a, -a tighter than -o" ){
+        REQUIRE( match({ "-name", "*.txt", "-o", "-name", "*.log", "-a", "-mtime", "0" })
+                 == Names{ "small.txt", "big.txt", "recent.log" } );
+        REQUIRE( match({ "-name", "*.txt", "-o", "-name", "*.log", "-mtime", "0" })
+                 == Names{ "small.txt", "big.txt", "recent.log" } );
+        REQUIRE( match({ "(", "-name", "*.txt", "-o", "-name", "*.log", ")", "-mtime", "0" })
+                 == Names{ "small.txt", "big.txt", "recent.log" } );
+        REQUIRE( match({ "!", "-name", "*.txt", "-o", "-name", "big.txt" }).count("small.txt") == 0 );
+        REQUIRE( match({ "!", "-name", "*.txt", "-o", "-name", "big.txt" }).size() == 7 );
+        REQUIRE( match({ "-not", "(", "-type", "f", "-or", "-type", "d", ")" }) == Names{ "link", "fifo" } );
+        REQUIRE( match({ "!", "!", "-type", "l" }) == Names{ "link" } );
+        REQUIRE( match({ "-type", "f", "-and", "!", "-name", "*.*" }) == Names{ "empty" } );
+    }
+}
+
+TEST_CASE( "Expression reorders operands without changing results" )
+{
+    auto directory = TemporaryDirectory{ "find_test_expression" };
+    const auto& root = directory.path();
+    make_file( root / "empty", 0 );
+    make_file( root / "small.txt", 1 );
+    make_file( root / "big.txt", 1025 );
+    make_file( root / "big.log", 2048, 25 * 60 * 60 );
+    make_file( root / "old.txt", 10, 3 * 24 * 60 * 60 );
+    fs::create_directory( root / "dir.txt" );
+    fs::create_symlink( "big.txt", root / "link.txt" );
+
+    SECTION( "the cheap tests go first" ){
+        REQUIRE( Expression{ { "-size", "+1k", "-name", "*.txt" } }.to_string()
+                 == "( -name *.txt -a -size +1k )" );
+        REQUIRE( Expression{ { "-perm", "644", "-o", "-type", "d" } }.to_string()
+                 == "( -type d -o -perm 644 )" );
+        REQUIRE( Expression{ { "-mtime", "+1", "(", "-regex", "x", "-name", "*.c", ")" } }.to_string()
+                 == "( -name *.c -a -regex x -a -mtime +1 )" );
+    }
+
+    // The value of every reordered expression is checked against its tests
+    // combined the way they are written
+    const auto size = evaluate( { "-size", "+1k" }, root );
+    const auto txt = evaluate( { "-name", "*.txt" }, root );
+    const auto file = evaluate( { "-type", "f" }, root );
+    const auto old = evaluate( { "-mtime", "+1" }, root );
+    const auto recent = evaluate( { "-mmin", "-60" }, root );
+
+    const auto check = [&root]( const Tokens& tokens, const auto& expected ){
+        for( const auto& [name, matched] : evaluate(tokens, root) ){
+            INFO( name );
+            REQUIRE( matched == expected(name) );
+        }
+    };
+    check( { "-size", "+1k", "-name", "*.txt" },
+           [&]( const std::string& n ){ return size.at(n) && txt.at(n); } );
+    check( { "-size", "+1k", "-o", "-name", "*.txt" },
+           [&]( const std::string& n ){ return size.at(n) || txt.at(n); } );
+    check( { "-mtime", "+1", "-o", "-type", "f", "-size", "+1k", "-o", "!", "-name", "*.txt" },
+           [&]( const std::string& n ){ return old.at(n) || (file.at(n) && size.at(n)) || !txt.at(n); } );
+    check( { "!", "(", "-mmin", "-60", "-o", "-mtime", "+1", ")", "-type", "f", "-name", "*.txt" },
+           [&]( const std::string& n ){ return !(recent.at(n) || old.at(n)) && file.at(n) && txt.at(n); } );
+    check( { "(", "-size", "+1k", "-o", "-mtime", "+1", ")", "(", "-type", "f", "-o", "-name", "*.txt", ")" },
+           [&]( const std::string& n ){ return (size.at(n) || old.at(n)) && (file.at(n) || txt.at(n)); } );
+}
@@ -0,0 +1,147 @@
+#include "catch/catch.hpp"
+#include "path_index.hpp"
+#include "temporary_directory.hpp"
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// The paths the index has in and below under
+auto search( const PathIndex& index, const std::string& under = {} ) -> std::set<std::string>
+{
+    auto paths = std::set<std::string>{};
+    const auto succeeded = index.search( under, everything, [&paths]( const std::string& path ){ paths.insert(path); } );
+    REQUIRE( succeeded );
+    return paths;
+}
+
+// The paths below root on the file system
+auto crawl( const fs::path& root ) -> std::set<std::string>
+{
+    auto paths = std::set<std::string>{};
+    for( const auto& entry : fs::recursive_directory_iterator(root) ){
+        paths.insert( entry.path().string() );
+    }
+    return paths;
+}
+} // namespace
+
+
+TEST_CASE( "PathIndex finds what a crawl finds" )
+{
+    auto directory = TemporaryDirectory{ "find_test_index" };
+    const auto& root = directory.path();
+    const auto db = (root / "index.db").string();
+    const auto tree = root / "tree";
+    // Names sharing long prefixes, and names and directories long and many
+    // enough to need varints of more than one byte
+    const auto long_name = std::string(200, 'n');
+    fs::create_directories( tree / long_name / "inner" );
+    fs::create_directories( tree / "abc" / "abd" );
+    for( int i = 0; i != 200; ++i ){
+        std::ofstream{ tree / ("prefix." + std::to_string(i)) };
+        std::ofstream{ tree / long_name / (long_name + std::to_string(i)) };
+    }
+    std::ofstream{ tree / "abc" / "abd" / "abe" };
+    fs::create_symlink( "abc", tree / "link" );
+
+    const auto statistics = PathIndex::build( db, tree.string() + "/./" );
+    REQUIRE( statistics.errors == 0 );
+    REQUIRE( statistics.directories == 5 );
+    REQUIRE( statistics.read == 5 );
+
+    const auto index = PathIndex{ db };
+    REQUIRE( index.root() == tree.string() );
+    REQUIRE( index.directories() == 5 );
+    REQUIRE( index.entries() == statistics.entries );
+    REQUIRE( search(index) == crawl(tree) );
+
+    SECTION( "below a directory, however it is spelled" ){
+        auto expected = crawl( tree / "abc" );
+        REQUIRE( search(index, (tree / "abc").string()) == expected );
+        REQUIRE( search(index, (tree / "abc" / "abd" / "..").string() + "/") == expected );
+        REQUIRE( search(index, root.string()) == crawl(tree) );
+    }
+
+    SECTION( "the predicate decides" ){
+        auto paths = std::set<std::string>{};
+        const auto match = []( std::string_view name, jam::DirectoryEntry& entry ){
+            return name.substr(0, 2) == "ab" && entry.type() == jam::EntryType::directory;
+        };
+        REQUIRE( index.search( {}, match, [&paths]( const std::string& path ){ paths.insert(path); } ) );
+        REQUIRE( paths == std::set<std::string>{ (tree / "abc").string(), (tree / "abc" / "abd").string() } );
+    }
+
+    SECTION( "a path beside the root is an error" ){
+        REQUIRE_THROWS_AS( search(index, (root / "elsewhere").string()), std::runtime_error );
+        REQUIRE_THROWS_AS( search(index, (tree.string() + "x")), std::runtime_error );
+    }
+}
+
+TEST_CASE( "PathIndex refresh reads only the directories that changed" )
+{
+    auto directory = TemporaryDirectory{ "find_test_index" };
+    const auto& root = directory.path();
+    const auto db = (root / "index.db").string();
+    const auto tree = root / "tree";
+    fs::create_directories( tree / "same" / "deeper" );
+    fs::create_directories( tree / "changed" );
+    std::ofstream{ tree / "same" / "deeper" / "file" };
+    std::ofstream{ tree / "changed" / "old" };
+    PathIndex::build( db, tree.string() );
+
+    SECTION( "nothing changed" ){
+        const auto statistics = PathIndex::refresh( db );
+        REQUIRE( statistics.errors == 0 );
+        REQUIRE( statistics.directories == 4 );
+        REQUIRE( statistics.read == 0 );
+        REQUIRE( search(PathIndex{ db }) == crawl(tree) );
+    }
+
+    SECTION( "an entry created, one removed" ){
+        std::ofstream{ tree / "changed" / "new" };
+        fs::remove( tree / "changed" / "old" );
+        const auto statistics = PathIndex::refresh( db );
+        REQUIRE( statistics.read == 1 );
+        REQUIRE( search(PathIndex{ db }) == crawl(tree) );
+    }
+
+    SECTION( "a directory created below an unchanged one" ){
+        fs::create_directory( tree / "same" / "deeper" / "new" );
+        std::ofstream{ tree / "same" / "deeper" / "new" / "file" };
+        const auto statistics = PathIndex::refresh( db );
+        // The directory that got the new one, and the new one
+        REQUIRE( statistics.read == 2 );
+        REQUIRE( statistics.directories == 5 );
+        REQUIRE( search(PathIndex{ db }) == crawl(tree) );
+    }
+}
+
+TEST_CASE( "PathIndex refuses damaged files" )
+{
+    auto directory = TemporaryDirectory{ "find_test_index" };
+    const auto& root = directory.path();
+    const auto db = (root / "index.db").string();
+    fs::create_directories( root / "tree" / "sub" );
+    for( int i = 0; i != 20; ++i ){
+        std::ofstream{ root / "tree" / "sub" / ("file." + std::to_string(i)) };
+    }
+    PathIndex::build( db, (root / "tree").string() );
+
+    SECTION( "no index at all" ){
+        std::ofstream{ db } << "not an index";
+        REQUIRE_THROWS_WITH( PathIndex{ db }, Catch::Contains("is no index") );
+    }
+
+    SECTION( "truncated" ){
+        fs::resize_file( db, fs::file_size(db) - 5 );
+        const auto index = PathIndex{ db };
+        REQUIRE_THROWS_WITH( search(index), "The index is damaged" );
+        REQUIRE_THROWS_WITH( PathIndex::refresh(db), "The index is damaged" );
+    }
+}
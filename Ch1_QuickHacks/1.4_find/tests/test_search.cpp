@@ -0,0 +1,53 @@
+#include "catch/catch.hpp"
+#include "search.hpp"
+#include "temporary_directory.hpp"
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using Paths = std::vector<std::string>;
+
+namespace
+{
+auto walk( Search search, const fs::path& root ) -> Paths
+{
+    auto paths = Paths{};
+    const auto succeeded = search.run( root.string(), everything,
+                                       [&paths]( const std::string& path ){ paths.push_back(path); } );
+    REQUIRE( succeeded );
+    return paths;
+}
+} // namespace
+
+
+TEST_CASE( "Search emits in directory order whatever the buffer limit" )
+{
+    // Wide, so that the directories found outnumber the matches held back
+    auto directory = TemporaryDirectory{ "find_test_search" };
+    const auto& root = directory.path();
+    for( int i = 0; i != 100; ++i ){
+        const auto sub = root / ("d" + std::to_string(i));
+        fs::create_directories( sub / "s" );
+        std::ofstream{ sub / "a" };
+        std::ofstream{ sub / "s" / "b" };
+    }
+
+    const auto expected = walk( Search{ 1 }, root );
+    REQUIRE( expected.size() == 400 );
+    REQUIRE( std::set<std::string>( expected.begin(), expected.end() ).size() == expected.size() );
+    for( const auto limit : { std::size_t{1}, std::size_t{3}, std::size_t{50}, Search::default_buffer_limit } ){
+        INFO( limit );
+        REQUIRE( walk( Search{ 4, Search::Order::directory, limit }, root ) == expected );
+    }
+
+    auto unordered = walk( Search{ 4, Search::Order::unordered }, root );
+    std::sort( unordered.begin(), unordered.end() );
+    auto sorted = expected;
+    std::sort( sorted.begin(), sorted.end() );
+    REQUIRE( unordered == sorted );
+}
@@ -3,18 +3,15 @@
 #include <string>
 #include <vector>
 #include <regex>
-#include <utility>
-#include <thread>
-#include <future>
 #include <stdexcept>
 #include "clara/clara.hpp"
+#include "jam/pipeline.hpp"
 
 using std::cout;
 using std::endl;
 using std::string;
 using std::vector;
 using std::regex;
-using std::smatch;
 using std::ifstream;
 using clara::Arg;
 using clara::Help;
@@ -24,37 +21,14 @@ namespace
 bool g_help_flag;
 string g_pattern;
 vector<string> g_file_names;
-} // namespace
-
-
-using LineMatch = std::pair<size_t,string>;
-
-namespace std
-{
-    std::ostream& operator<<( std::ostream& os, const LineMatch& lm );
-}
 
-class FileMatches
-{
-public:
-    explicit FileMatches( string file_name )
-        : fname(file_name) { }
-    
-    void push_back( LineMatch match )
-        { matches.push_back(std::move(match)); }
-
-    auto empty() const noexcept -> bool
-    { return matches.empty(); }
-    
-    friend std::ostream& operator<<( std::ostream& os, const FileMatches& fm );
-private:
-    string fname;
-    vector<LineMatch> matches;
-};
+// Between the number of a matching line and the line
+const string separator{":    "};
+} // namespace
 
 
-auto grep_file( const string& fname, const regex& re ) -> FileMatches;
-auto grep_files( const vector<string>, const regex& re) -> vector<FileMatches>;
+auto grep_file( const string& fname, const regex& re, std::ostream& os ) -> void;
+auto grep_files( const vector<string>& files, const regex& re, std::ostream& os ) -> void;
 
 
 int main( int argc, char* argv[] )
@@ -68,11 +42,9 @@ try{
         cout << clip << endl;
         return !clip_result;
     }
-    
+
     auto re = regex( g_pattern );
-    auto results = grep_files( g_file_names, re );
-    for( const auto& file_match : results )
-        cout << file_match;
+    grep_files( g_file_names, re, cout );
 
     return 0;
 }
@@ -88,54 +60,36 @@ catch( const std::exception& e )
 }
 
 
-auto grep_file( const string& fname, const regex& re ) -> FileMatches
+// The file name, then every matching line with its number. Reading, matching
+// and writing are the stages of a jam::Pipeline, each on a thread of its own,
+// so the next lines are read while these are searched. The match stage counts
+// every line and puts the number in front of the ones it keeps.
+auto grep_file( const string& fname, const regex& re, std::ostream& os ) -> void
 {
-    cout << "grep_file on thread[" << std::this_thread::get_id()
-        << "]" << endl;
     auto ifs = ifstream{fname};
     if( !ifs )
         throw std::runtime_error( "Unable to open the file " + fname );
-    
-    auto result = FileMatches{fname};
-    auto n = size_t{1};
-    for( string line; getline(ifs, line); ++n){
-        if( std::regex_search(line,  re) ){
-            result.push_back( {n, std::move(line)} );
-        }
-    }
-    return result;
+
+    os << fname << '\n';
+    auto pipeline = jam::Pipeline{};
+    pipeline.filter_transform( [&re, n = size_t{0}]( string& line ) mutable {
+                ++n;
+                if( !std::regex_search( line, re ) )
+                    return false;
+                line.insert( 0, std::to_string(n) + separator );
+                return true;
+            }, "match" );
+    pipeline.run( ifs, os );
 }
 
-auto grep_files( const vector<string> files, const regex& re) -> vector<FileMatches>
+auto grep_files( const vector<string>& files, const regex& re, std::ostream& os ) -> void
 {
-    auto intermediate_result = vector<std::future<FileMatches>>();
     for( const string& file : files ){
-        intermediate_result.push_back( std::async( grep_file, file, re) );
-    }
-    auto result = vector<FileMatches>();
-    for( auto&& f : intermediate_result ){
         try{
-            result.push_back( std::move( f.get() ) );
+            grep_file( file, re, os );
         }
         catch( const std::runtime_error& e ){
             std::cerr << e.what() << endl;
         }
     }
-    return result;
-}
-
-std::ostream& operator<<( std::ostream& os, const FileMatches& fm )
-{
-    os << fm.fname << endl;
-    for( const auto& lm : fm.matches )
-        os << lm << endl;
-    return os;
-}
-
-namespace std
-{
-    std::ostream& operator<<( std::ostream& os, const LineMatch& lm )
-    {
-        return os << lm.first << ":    " << lm.second;
-    }
 }
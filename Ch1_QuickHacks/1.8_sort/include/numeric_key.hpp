@@ -0,0 +1,33 @@
+#ifndef SORT_NUMERIC_KEY_INCLUDED_HPP_
+#define SORT_NUMERIC_KEY_INCLUDED_HPP_
+
+#include <string>
+#include <string_view>
+
+
+// Number a line is ordered by with -n, as it is written: the digits are
+// compared as text, so long numbers keep every digit
+struct DecimalKey
+{
+    bool negative;
+    std::string_view integer;   // without leading zeros
+    std::string_view fraction;  // without trailing zeros
+};
+
+// Value a line is ordered by with -g
+struct GeneralKey
+{
+    int rank;       // 0 - not a number, 1 - NaN, 2 - a number
+    double value;
+};
+
+// The keys point into the line, which has to outlive them
+auto decimal_key( const std::string& line ) -> DecimalKey;
+auto general_key( const std::string& line ) -> GeneralKey;
+
+// <0, 0 or >0, like std::string::compare
+auto compare( const DecimalKey& lhs, const DecimalKey& rhs ) noexcept -> int;
+auto compare( const GeneralKey& lhs, const GeneralKey& rhs ) noexcept -> int;
+
+
+#endif /* SORT_NUMERIC_KEY_INCLUDED_HPP_ */
@@ -6,9 +6,13 @@
 #include <algorithm>
 #include <iterator>
 #include <utility>
+#include <string_view>
 #include <functional>
 #include <future>
+#include <stdexcept>
 #include <clara/clara.hpp>
+#include "jam/line_writer.hpp"
+#include "numeric_key.hpp"
 
 using std::cout;
 using std::endl;
@@ -28,6 +32,8 @@ struct commandline_args
     bool dictionary_order{false};
     bool random_sort{false};
     bool check{false};
+    bool numeric_sort{false};
+    bool general_numeric_sort{false};
     vector<string> infiles{};
     string outfile{};
     bool help_flag{false};
@@ -54,6 +60,8 @@ auto process_files( const InContainer& files, Predicate pred ) -> OutContainer;
 template<typename Container>
 auto write_lines( const string& fname, const Container& container ) -> void;
 
+auto numeric_sort( Lines& lines, const commandline_args& args ) -> void;
+
 
 template<typename T>
 class IgnoreCaseMixin : public T
@@ -132,7 +140,7 @@ IgnoreLeadingBlanksWrapper<T> makeIgnoreLeadingBlanksWrapper( T&& pred )
 
 
 int main( int argc, char* argv[] )
-{
+try{
     auto cli_args = commandline_args{};
     auto cli
         = Opt( cli_args.ignore_case, "Treat all lowercase as uppercase" )
@@ -141,6 +149,11 @@ int main( int argc, char* argv[] )
              ["-r"]["--reverse"]
         | Opt( cli_args.ignore_leading_blanks, "Ignore leading whitespace" )
              ["-b"]["--ignore-leading-blanks"]
+        | Opt( cli_args.numeric_sort )
+             ["-n"]["--numeric-sort"]("Compare according to string numerical value")
+        | Opt( cli_args.general_numeric_sort )
+             ["-g"]["--general-numeric-sort"]("Compare according to general numerical value,"
+                                              " exponents, inf and nan included")
         | Opt( cli_args.outfile, "Output file" )
              ["-o"]["--output-file"].required()
         | Arg( cli_args.infiles, "[FILE]..." )
@@ -152,6 +165,22 @@ int main( int argc, char* argv[] )
         return 1;
     }
 
+    if( cli_args.numeric_sort || cli_args.general_numeric_sort ){
+        auto lines = Lines{};
+        if( cli_args.infiles.empty() )
+            lines = get_lines<Lines>(std::cin);
+        for( const auto& file : cli_args.infiles ){
+            auto ifs = std::ifstream{file};
+            if( !ifs )
+                throw std::runtime_error( "Failed to open the file " + file );
+            auto file_lines = get_lines<Lines>(ifs);
+            std::move(file_lines.begin(), file_lines.end(), std::back_inserter(lines));
+        }
+        numeric_sort(lines, cli_args);
+        write_lines(cli_args.outfile, lines);
+        return 0;
+    }
+
     std::function<bool(const string&, const string&)> predicate;
     if( cli_args.reverse_order )
         predicate = std::greater<string>();
@@ -172,6 +201,10 @@ int main( int argc, char* argv[] )
         write_lines(cli_args.outfile, lines);
     }
 }
+catch( const std::exception& ex ){
+    std::cerr << ex.what() << std::endl;
+    return 1;
+}
 
 template<typename Container>
 auto get_lines( std::istream& is ) -> Container
@@ -214,6 +247,8 @@ template<typename Container, typename Predicate>
 auto process_file( const string& fname, Predicate pred ) -> Container
 {
     auto ifs = std::ifstream{fname};
+    if( !ifs )
+        throw std::runtime_error( "Failed to open the file " + fname );
     auto lines = get_lines<Container>(ifs);
     sort_lines(lines, pred);
     return lines;
@@ -239,9 +274,40 @@ auto process_files( const InContainer& files, Predicate pred ) -> OutContainer
 template<typename Container>
 auto write_lines( const string& fname, const Container& lines ) -> void
 {
-    auto ofs = std::ofstream{fname};
-    std::ostream& os = ofs ? ofs : cout;
-    for( const auto& line : lines ){
-        os << line << "\n";
-    }
+    auto writer = jam::LineWriter{fname};
+    writer.write_lines(lines);
+    writer.flush();
+}
+
+// Every key is parsed once into a side array, the sort then only moves
+// (key, index) pairs around and the lines are put in order at the end
+template<typename MakeKey>
+auto sort_by_key( Lines& lines, MakeKey make_key, bool reverse ) -> void
+{
+    using KeyIndex = std::pair<decltype(make_key(lines.front())), std::size_t>;
+    auto keys = vector<KeyIndex>{};
+    keys.reserve(lines.size());
+    for( std::size_t i = 0; i != lines.size(); ++i )
+        keys.emplace_back( make_key(lines[i]), i );
+
+    // Equal keys keep their input order, reversed or not
+    std::sort( keys.begin(), keys.end(), [reverse]( const KeyIndex& lhs, const KeyIndex& rhs ){
+        if( const auto order = compare(lhs.first, rhs.first); order != 0 )
+            return reverse ? order > 0 : order < 0;
+        return lhs.second < rhs.second;
+    });
+
+    auto sorted = Lines{};
+    sorted.reserve(lines.size());
+    for( const auto& key : keys )
+        sorted.push_back( std::move(lines[key.second]) );
+    lines = std::move(sorted);
+}
+
+auto numeric_sort( Lines& lines, const commandline_args& args ) -> void
+{
+    if( args.general_numeric_sort )
+        sort_by_key( lines, general_key, args.reverse_order );
+    else
+        sort_by_key( lines, decimal_key, args.reverse_order );
 }
@@ -0,0 +1,76 @@
+#include "numeric_key.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+
+// Leading blanks are skipped. -n takes an optional '-', digits and a decimal
+// point; a line that is no number at all is 0.
+auto decimal_key( const std::string& line ) -> DecimalKey
+{
+    const auto* first = line.data();
+    const auto* last = line.data() + line.size();
+    while( first != last && (*first == ' ' || *first == '\t') )
+        ++first;
+
+    auto key = DecimalKey{ false, {}, {} };
+    if( first != last && *first == '-' ){
+        key.negative = true;
+        ++first;
+    }
+    const auto is_digit = []( char ch ){ return ch >= '0' && ch <= '9'; };
+    const auto* integer = std::find_if_not(first, last, is_digit);
+    const auto* digits = std::find_if(first, integer, []( char ch ){ return ch != '0'; });
+    key.integer = std::string_view{ digits, static_cast<std::size_t>(integer - digits) };
+    if( integer != last && *integer == '.' ){
+        const auto* fraction = integer + 1;
+        auto end = std::find_if_not(fraction, last, is_digit);
+        while( end != fraction && end[-1] == '0' )
+            --end;
+        key.fraction = std::string_view{ fraction, static_cast<std::size_t>(end - fraction) };
+    }
+    // -0 is 0
+    if( key.integer.empty() && key.fraction.empty() )
+        key.negative = false;
+    return key;
+}
+
+auto compare( const DecimalKey& lhs, const DecimalKey& rhs ) noexcept -> int
+{
+    if( lhs.negative != rhs.negative )
+        return lhs.negative ? -1 : 1;
+    // Without leading zeros the longer integer part is the larger one
+    auto magnitude = lhs.integer.size() != rhs.integer.size()
+                   ? (lhs.integer.size() < rhs.integer.size() ? -1 : 1)
+                   : lhs.integer.compare(rhs.integer);
+    if( magnitude == 0 )
+        magnitude = lhs.fraction.compare(rhs.fraction);
+    return lhs.negative ? -magnitude : magnitude;
+}
+
+// -g takes anything strtod takes - a sign, hex, exponents, inf and nan -
+// leading blanks skipped. Lines that are no number at all sort before every
+// number, NaNs just after them.
+auto general_key( const std::string& line ) -> GeneralKey
+{
+    const auto* first = line.data();
+    const auto* last = line.data() + line.size();
+    while( first != last && (*first == ' ' || *first == '\t') )
+        ++first;
+
+    // strtod() stops at the end of the line - std::string keeps it terminated
+    char* end = nullptr;
+    const auto value = std::strtod(first, &end);
+    if( end == first )
+        return { 0, 0.0 };
+    if( std::isnan(value) )
+        return { 1, 0.0 };
+    return { 2, value };
+}
+
+auto compare( const GeneralKey& lhs, const GeneralKey& rhs ) noexcept -> int
+{
+    if( lhs.rank != rhs.rank )
+        return lhs.rank < rhs.rank ? -1 : 1;
+    return lhs.value < rhs.value ? -1 : (rhs.value < lhs.value ? 1 : 0);
+}
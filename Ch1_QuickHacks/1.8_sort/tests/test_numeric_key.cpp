@@ -0,0 +1,46 @@
+#include "catch/catch.hpp"
+#include "numeric_key.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using Lines = std::vector<std::string>;
+
+namespace
+{
+template<typename MakeKey>
+auto sorted( Lines lines, MakeKey make_key ) -> Lines
+{
+    std::stable_sort( lines.begin(), lines.end(), [&]( const std::string& lhs, const std::string& rhs ){
+        return compare(make_key(lhs), make_key(rhs)) < 0;
+    });
+    return lines;
+}
+} // namespace
+
+
+TEST_CASE( "decimal_key compares numbers as written" )
+{
+    REQUIRE( sorted( {"10", "-2", "x", "3.50", "003.5", "-0", "12345678901234567890", "3.49"}, decimal_key )
+             == Lines{"-2", "x", "-0", "3.49", "3.50", "003.5", "10", "12345678901234567890"} );
+}
+
+TEST_CASE( "general_key takes anything strtod takes" )
+{
+    SECTION( "a leading plus sign" ){
+        REQUIRE( sorted( {"+5", "3", "-2"}, general_key ) == Lines{"-2", "3", "+5"} );
+        REQUIRE( general_key(" +5").rank == 2 );
+        REQUIRE( general_key(" +5").value == 5.0 );
+    }
+
+    SECTION( "hex numbers" ){
+        REQUIRE( sorted( {"0x10", "10", "3", "-2", "0x1p4", "-0x3"}, general_key )
+                 == Lines{"-0x3", "-2", "3", "10", "0x10", "0x1p4"} );
+        REQUIRE( general_key("0x10").value == 16.0 );
+    }
+
+    SECTION( "exponents, infinities and not-a-numbers" ){
+        REQUIRE( sorted( {"1e3", "inf", "nan", "abc", "-inf", "999"}, general_key )
+                 == Lines{"abc", "nan", "-inf", "999", "1e3", "inf"} );
+    }
+}
@@ -7,8 +7,10 @@
 #include <iterator>
 #include <utility>
 #include <stdexcept>
+#include <string_view>
 #include <gsl/gsl>
 #include "clara/clara.hpp"
+#include "jam/mapped_lines.hpp"
 
 using std::cout; using std::endl; using std::cin;
 using std::string; using std::vector; using std::list;
@@ -105,6 +107,15 @@ public:
         else
             data_.emplace_back( std::move(line) );
     }
+    // A line of a mapping is only copied when it starts a new group
+    void push_back( std::string_view line )
+    {
+        const auto span = gsl::cstring_span<>( line.data(), static_cast<std::ptrdiff_t>(line.size()) );
+        if( !data_.empty() && predicate_(data_.back(), span) )
+            ++data_.back();
+        else
+            data_.emplace_back( string{line} );
+    }
     void push_back( const string& line )
     {
         if( !data_.empty() && predicate_(data_.back(), line) )
@@ -149,6 +160,13 @@ std::ostream& operator<<( std::ostream& os, const Lines& lines )
 auto get_lines( const commandline_args& args ) -> Lines
 {
     auto lines = Lines{args};
+    if( jam::MappedLines::can_map(args.infile) ){
+        const auto mapped = jam::MappedLines{args.infile};
+        for( auto line : mapped ){
+            lines.push_back(line);
+        }
+        return lines;
+    }
     auto ifs = std::ifstream{args.infile};
     auto& is = ifs.is_open() ? ifs : std::cin;
     for( string line; getline(is, line); ){
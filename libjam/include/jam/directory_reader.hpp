@@ -0,0 +1,102 @@
+#ifndef JAM_DIRECTORY_READER_INCLUDED_HPP_
+#define JAM_DIRECTORY_READER_INCLUDED_HPP_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+#include <sys/stat.h>
+#include <dirent.h>
+
+
+namespace jam
+{
+
+
+/* Low-level directory reading */
+/* ------------------------------------------------------------------------- */
+enum class EntryType : unsigned char
+{
+    unknown,
+    regular,
+    directory,
+    symlink,
+    other       // devices, fifos and sockets
+};
+
+class DirectoryReader;
+
+// An entry of the directory a DirectoryReader is reading. Valid until the
+// reader's next call to next().
+// The type comes from the directory listing (d_type) when the filesystem
+// fills it in; the entry is stat'ed only when the type is missing or
+// status() is asked for, and at most once.
+class DirectoryEntry
+{
+public:
+    DirectoryEntry() noexcept = default;
+    // An entry that was not listed by a reader - a path out of an index, say.
+    // name is relative to dir_fd, AT_FDCWD for the working directory, and must
+    // be followed by a '\0'.
+    DirectoryEntry( int dir_fd, std::string_view name, EntryType type = EntryType::unknown ) noexcept
+        : m_dir_fd{dir_fd}, m_name{name}, m_type{type}
+        { }
+
+    auto name() const noexcept -> std::string_view { return m_name; }
+    auto inode() const noexcept -> ino_t { return m_inode; }
+    // Type of the entry itself, symbolic links are not followed
+    auto type() -> EntryType;
+    // lstat() of the entry. Throws std::runtime_error if it fails.
+    auto status() -> const struct stat&;
+    auto has_status() const noexcept -> bool { return m_has_status; }
+
+private:
+    friend class DirectoryReader;
+
+    int m_dir_fd{-1};
+    std::string_view m_name{};
+    ino_t m_inode{0};
+    EntryType m_type{EntryType::unknown};
+    bool m_has_status{false};
+    struct stat m_status{};
+};
+
+// Reads a directory with openat(2) and getdents64(2) in large blocks, without
+// the per-entry allocations of a directory_iterator. Elsewhere than on Linux
+// readdir(3) on the opened descriptor takes the place of getdents64. "." and ".." are left
+// out. Names are relative to the directory, whose descriptor can be used
+// with the *at() calls.
+class DirectoryReader
+{
+public:
+    static constexpr std::size_t default_block_size{1 << 16};
+
+    // Opens path relative to dir_fd, AT_FDCWD for the working directory.
+    // Throws std::runtime_error if it is no directory or cannot be read.
+    DirectoryReader( int dir_fd, const char* path, std::size_t block_size = default_block_size );
+    explicit DirectoryReader( const std::string& path, std::size_t block_size = default_block_size );
+    DirectoryReader( DirectoryReader&& other ) noexcept;
+    DirectoryReader& operator=( DirectoryReader&& other ) noexcept;
+    ~DirectoryReader();
+
+    auto next( DirectoryEntry& entry ) -> bool;
+    auto fd() const noexcept -> int { return m_fd; }
+
+private:
+    void close() noexcept;
+
+    int m_fd{-1};
+    // The readdir(3) stream, where there is no getdents64
+    DIR* m_dir{nullptr};
+    std::vector<char> m_block;
+    std::size_t m_offset{0};
+    std::size_t m_size{0};
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_DIRECTORY_READER_INCLUDED_HPP_ */
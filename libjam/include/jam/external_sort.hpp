@@ -0,0 +1,243 @@
+#ifndef JAM_EXTERNAL_SORT_INCLUDED_HPP_
+#define JAM_EXTERNAL_SORT_INCLUDED_HPP_
+
+#include "jam/jam.hpp"
+#include <istream>
+#include <ostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Temporary files */
+/* ------------------------------------------------------------------------- */
+// A uniquely named file, removed again when the object goes away.
+// An empty directory means $TMPDIR, or /tmp if that is not set.
+class TemporaryFile
+{
+public:
+    explicit TemporaryFile( const std::string& directory = {} );
+    TemporaryFile( const TemporaryFile& ) = delete;
+    TemporaryFile& operator=( const TemporaryFile& ) = delete;
+    TemporaryFile( TemporaryFile&& other ) noexcept;
+    TemporaryFile& operator=( TemporaryFile&& other ) noexcept;
+    ~TemporaryFile();
+
+    auto path() const noexcept -> const std::string& { return m_path; }
+    // Renames the file to fname, replacing whatever is there but keeping its
+    // permissions. The file is no longer removed afterwards.
+    void keep_as( const std::string& fname );
+private:
+    std::string m_path;
+};
+
+// Whether both names refer to the same file, by device and inode.
+// False if either of them does not exist.
+auto same_file( const std::string& lhs, const std::string& rhs ) -> bool;
+/* ------------------------------------------------------------------------- */
+
+
+/* External merge sort */
+/* ------------------------------------------------------------------------- */
+// Collects lines until the memory budget is used up, sorts them and spills
+// the sorted run to a temporary file. write() merges all of the runs with a
+// heap of run cursors. Fills like any other container, so it works with
+// jam::get_lines(is, sorter).
+//
+// The budget covers what a run takes at its peak, while it is being sorted:
+// each line's allocation, its slot in the run with room for the vector to
+// grow, and what sort_lines_by_key() adds per line - a copy of the key in
+// its arena, an offset and an index.
+template<typename Predicate>
+class ExternalSorter
+{
+public:
+    // Runs merged at once - more runs than that are merged in several passes
+    static constexpr std::size_t max_merge_runs{64};
+
+    // Memory a line is charged with against the budget
+    static auto line_cost( const std::string& line ) noexcept -> std::size_t
+    {
+        return 2 * sizeof(std::string) + line.capacity() + 1
+             + line.size() + 2 * sizeof(std::size_t) + sizeof(std::string_view);
+    }
+
+    ExternalSorter( Predicate predicate, std::size_t memory_budget,
+                    std::string temp_directory = {} )
+        : m_predicate(std::move(predicate))
+        , m_memory_budget{memory_budget}
+        , m_temp_directory{std::move(temp_directory)}
+        { }
+
+    void emplace_back( std::string&& line )
+    {
+        m_run_bytes += line_cost(line);
+        m_run.push_back(std::move(line));
+        if( m_run_bytes >= m_memory_budget ){
+            spill();
+        }
+    }
+    void emplace_back( const std::string& line ) { emplace_back( std::string{line} ); }
+    void push_back( std::string&& line ) { emplace_back( std::move(line) ); }
+    void push_back( const std::string& line ) { emplace_back( line ); }
+
+    // Number of runs spilled to disk so far
+    auto runs() const noexcept -> std::size_t { return m_runs.size(); }
+
+    // Writes all of the lines in sorted order. Everything fitting into the
+    // budget is sorted in memory without touching the disk. Throws
+    // std::runtime_error if the runs or os cannot be written.
+    void write( std::ostream& os )
+    {
+        auto writer = StreamWriter{os};
+        write_lines( writer );
+        if( !os.flush() ){
+            throw std::runtime_error( "Failed to write the sorted lines" );
+        }
+    }
+
+    // The same into anything with write_line( std::string_view ), like a
+    // jam::LineWriter
+    template<typename Writer>
+    void write_lines( Writer& writer )
+    {
+        if( m_runs.empty() ){
+            sort_lines_by_key(m_run, m_predicate);
+            for( const auto& line : m_run ){
+                writer.write_line(line);
+            }
+            m_run.clear();
+            return;
+        }
+        spill();
+        while( m_runs.size() > max_merge_runs ){
+            auto merged = std::vector<TemporaryFile>{};
+            for( auto first = m_runs.begin(); first != m_runs.end(); ){
+                const auto last = first + std::min<std::ptrdiff_t>(max_merge_runs, m_runs.end() - first);
+                merged.emplace_back(m_temp_directory);
+                auto ofs = std::ofstream{merged.back().path(), std::ios::binary};
+                auto run_writer = StreamWriter{ofs};
+                merge(first, last, run_writer);
+                if( !ofs.flush() ){
+                    throw std::runtime_error( "Failed to write the run " + merged.back().path() );
+                }
+                first = last;
+            }
+            m_runs = std::move(merged);
+        }
+        merge(m_runs.begin(), m_runs.end(), writer);
+        m_runs.clear();
+    }
+
+private:
+    using RunIterator = typename std::vector<TemporaryFile>::iterator;
+
+    struct Cursor
+    {
+        std::string line;
+        std::unique_ptr<std::ifstream> input;
+        const std::string* path;
+    };
+
+    struct StreamWriter
+    {
+        std::ostream& os;
+        void write_line( const std::string& line ) { os << line << '\n'; }
+    };
+
+    // Reads the next line of a run, false at its end
+    static auto next( Cursor& cursor ) -> bool
+    {
+        if( getline(*cursor.input, cursor.line) ){
+            return true;
+        }
+        if( cursor.input->bad() ){
+            throw std::runtime_error( "Failed to read the run " + *cursor.path );
+        }
+        return false;
+    }
+
+    void spill()
+    {
+        if( m_run.empty() ){
+            return;
+        }
+        sort_lines_by_key(m_run, m_predicate);
+        m_runs.emplace_back(m_temp_directory);
+        auto ofs = std::ofstream{m_runs.back().path(), std::ios::binary};
+        for( const auto& line : m_run ){
+            ofs << line << '\n';
+        }
+        if( !ofs ){
+            throw std::runtime_error( "Failed to write the run " + m_runs.back().path() );
+        }
+        m_run.clear();
+        m_run.shrink_to_fit();
+        m_run_bytes = 0;
+    }
+
+    template<typename Writer>
+    void merge( RunIterator first, RunIterator last, Writer& writer )
+    {
+        // The heap keeps the cursor holding the smallest line at the front
+        auto heap_compare = [this]( Cursor& lhs, Cursor& rhs ){
+            return m_predicate(rhs.line, lhs.line);
+        };
+        auto heap = std::vector<Cursor>{};
+        for( ; first != last; ++first ){
+            auto cursor = Cursor{ {}, std::make_unique<std::ifstream>(first->path(), std::ios::binary),
+                                  &first->path() };
+            if( !*cursor.input ){
+                throw std::runtime_error( "Failed to open the run " + first->path() );
+            }
+            if( next(cursor) ){
+                heap.push_back(std::move(cursor));
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), heap_compare);
+        while( !heap.empty() ){
+            std::pop_heap(heap.begin(), heap.end(), heap_compare);
+            auto& cursor = heap.back();
+            writer.write_line(cursor.line);
+            if( next(cursor) ){
+                std::push_heap(heap.begin(), heap.end(), heap_compare);
+            }
+            else{
+                heap.pop_back();
+            }
+        }
+    }
+
+    Predicate m_predicate;
+    std::size_t m_memory_budget;
+    std::string m_temp_directory;
+    std::vector<std::string> m_run{};
+    std::size_t m_run_bytes{0};
+    std::vector<TemporaryFile> m_runs{};
+};
+
+template<typename Predicate>
+void external_sort( std::istream& is, std::ostream& os, Predicate pred,
+                    std::size_t memory_budget, const std::string& temp_directory = {} )
+{
+    auto sorter = ExternalSorter<Predicate>{ std::move(pred), memory_budget, temp_directory };
+    get_lines(is, sorter);
+    sorter.write(os);
+}
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_EXTERNAL_SORT_INCLUDED_HPP_ */
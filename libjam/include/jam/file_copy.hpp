@@ -0,0 +1,38 @@
+#ifndef JAM_FILE_COPY_INCLUDED_HPP_
+#define JAM_FILE_COPY_INCLUDED_HPP_
+
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Kernel-side copying */
+/* ------------------------------------------------------------------------- */
+// Ways of moving data between two file descriptors, fastest first
+enum class CopyMethod
+{
+    copy_file_range,    // file to regular file, may share extents on the same filesystem
+    splice,             // through a pipe - either end, or one made up in between
+    sendfile,           // from a file to anything
+    read_write          // plain read(2)/write(2) with a large buffer
+};
+
+auto to_string( CopyMethod method ) noexcept -> const char*;
+
+// Copies everything from in_fd, starting at its current offset, to out_fd.
+// Starts with the first method, and moves on to the next one as soon as the
+// kernel refuses a method for this pair of descriptors - off Linux that is
+// all but read_write. The bytes already
+// copied stay copied, the next method carries on from there.
+// Returns the number of bytes copied; throws std::runtime_error on errors.
+auto copy_fd( int in_fd, int out_fd,
+              CopyMethod first = CopyMethod::copy_file_range ) -> std::size_t;
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_FILE_COPY_INCLUDED_HPP_ */
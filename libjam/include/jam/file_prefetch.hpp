@@ -0,0 +1,84 @@
+#ifndef JAM_FILE_PREFETCH_INCLUDED_HPP_
+#define JAM_FILE_PREFETCH_INCLUDED_HPP_
+
+#include "jam/pipeline.hpp"
+#include <string>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Read-ahead across files */
+/* ------------------------------------------------------------------------- */
+// A file opened by FilePrefetcher. Owns the descriptor; fd is -1 and error
+// the errno of open(2) if the file could not be opened.
+class PrefetchedFile
+{
+public:
+    PrefetchedFile() noexcept = default;
+    PrefetchedFile( std::string name, int fd, int error ) noexcept
+        : m_name{std::move(name)}, m_fd{fd}, m_error{error}
+        { }
+    PrefetchedFile( PrefetchedFile&& other ) noexcept;
+    PrefetchedFile& operator=( PrefetchedFile&& other ) noexcept;
+    ~PrefetchedFile();
+
+    auto name() const noexcept -> const std::string& { return m_name; }
+    auto fd() const noexcept -> int { return m_fd; }
+    auto error() const noexcept -> int { return m_error; }
+
+private:
+    std::string m_name{};
+    int m_fd{-1};
+    int m_error{0};
+};
+
+// Opens a list of files in order on a background thread, and asks the kernel
+// to start reading the first window bytes of each one (posix_fadvise
+// WILLNEED), so that while one file is being read the next ones are already
+// on their way into the page cache.
+// At most depth opened files wait ahead of the consumer. With a depth of 0
+// the files are opened by next() itself, without a thread and without advice.
+//
+//     auto files = jam::FilePrefetcher{ names };
+//     for( auto file = jam::PrefetchedFile{}; files.next(file); ){
+//         ... read file.fd() ...
+//     }
+class FilePrefetcher
+{
+public:
+    static constexpr std::size_t default_depth{4};
+    static constexpr std::size_t default_window{std::size_t{16} << 20};
+
+    explicit FilePrefetcher( std::vector<std::string> files,
+                             std::size_t depth = default_depth,
+                             std::size_t window = default_window );
+    FilePrefetcher( const FilePrefetcher& ) = delete;
+    FilePrefetcher& operator=( const FilePrefetcher& ) = delete;
+    // Stops the background thread and closes the files nobody asked for
+    ~FilePrefetcher();
+
+    // The next file in list order, false once all of them were handed out
+    auto next( PrefetchedFile& file ) -> bool;
+
+private:
+    void prefetch();
+
+    std::vector<std::string> m_files;
+    std::size_t m_window;
+    std::size_t m_next{0};
+    BoundedQueue<PrefetchedFile> m_queue;
+    std::thread m_thread{};
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_FILE_PREFETCH_INCLUDED_HPP_ */
@@ -0,0 +1,79 @@
+#ifndef JAM_GLOB_INCLUDED_HPP_
+#define JAM_GLOB_INCLUDED_HPP_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <bitset>
+#include <cstdint>
+
+
+namespace jam
+{
+
+
+/* Compiled glob patterns */
+/* ------------------------------------------------------------------------- */
+// A shell wildcard pattern as find -name uses it: '*' matches any run of
+// characters, '?' any single character, "[...]" one character of a set -
+// ranges like a-z, negated by a leading '!' or '^' - and '\' quotes the next
+// character. A '[' without its ']' stands for itself, a leading '.' is not
+// special and '/' is an ordinary character - the same as fnmatch(3) without
+// flags. ignore_case folds ASCII letters, like FNM_CASEFOLD.
+//
+// The pattern is compiled once into the fixed-length pieces between the
+// stars. The common shapes - no star, "lit*", "*lit", "*lit*" - are
+// recognised and matched with a single comparison or search; other patterns
+// anchor the first and last piece and take the leftmost place for each of
+// the ones in between, without ever backtracking.
+class Glob
+{
+public:
+    explicit Glob( std::string_view pattern, bool ignore_case = false );
+
+    auto operator()( std::string_view name ) const noexcept -> bool;
+
+    auto pattern() const noexcept -> const std::string& { return m_pattern; }
+
+private:
+    struct Token
+    {
+        enum class Kind : std::uint8_t { character, any, set };
+        Kind kind;
+        unsigned char character;
+        std::uint16_t set;
+    };
+
+    // The tokens between two stars, each matching exactly one character.
+    // Pieces made of characters only also keep them as a string.
+    struct Piece
+    {
+        std::vector<Token> tokens{};
+        std::string literal{};
+        bool is_literal{true};
+    };
+
+    enum class Shape : std::uint8_t { exact, prefix, suffix, contains, general };
+
+    auto matches_at( const Piece& piece, std::string_view name, std::size_t pos ) const noexcept -> bool;
+    // Leftmost position in [first, last - piece size] where piece matches,
+    // std::string_view::npos if there is none
+    auto find( const Piece& piece, std::string_view name,
+               std::size_t first, std::size_t last ) const noexcept -> std::size_t;
+    auto fold( unsigned char ch ) const noexcept -> unsigned char;
+
+    std::string m_pattern;
+    bool m_ignore_case;
+    bool m_leading_star{false};
+    bool m_trailing_star{false};
+    Shape m_shape{Shape::general};
+    std::vector<Piece> m_pieces{};
+    std::vector<std::bitset<256>> m_sets{};
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_GLOB_INCLUDED_HPP_ */
@@ -4,14 +4,21 @@
 #include <istream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <list>
 #include <algorithm>
 #include <iterator>
 #include <utility>
+#include <numeric>
+#include <optional>
+#include <functional>
 #include <stdexcept>
 #include <type_traits>
+#include <future>
+#include <thread>
 #include <gsl/gsl>
+#include "jam/line_reader.hpp"
 
 
 namespace jam
@@ -20,13 +27,39 @@ namespace jam
 
 /* Reading a stream line by line */
 /* ------------------------------------------------------------------------- */
+// Containers declaring a stores_line_bytes member type copy the bytes of a
+// std::string_view into storage of their own (jam::LineBuffer). They take
+// lines straight out of the reader's buffer, without a std::string in between.
+template<typename Container, typename = void>
+struct stores_line_bytes : std::false_type { };
+template<typename Container>
+struct stores_line_bytes<Container, std::void_t<typename Container::stores_line_bytes>>
+    : std::true_type { };
+
+namespace detail
+{
+template<typename Container>
+void append_line( Container& container, std::string_view line )
+{
+    if constexpr( stores_line_bytes<Container>::value ){
+        container.emplace_back( line );
+    }
+    else{
+        container.emplace_back( std::string{line} );
+    }
+}
+} // namespace detail
+
+// The stream is read in large blocks by a jam::LineReader rather than one
+// getline() at a time.
 template<typename Container>
 auto get_lines( std::istream& is ) -> Container
     // requires push_back()
 {
     auto lines = Container{};
-    for( std::string line; getline(is, line); ){
-        lines.emplace_back(std::move(line));
+    auto reader = LineReader{is};
+    for( std::string_view line; reader.next(line); ){
+        detail::append_line( lines, line );
     }
     return lines;
 }
@@ -34,8 +67,9 @@ auto get_lines( std::istream& is ) -> Container
 template<typename Container>
 void get_lines( std::istream& is, Container& container )
 {
-    for( std::string line; getline(is, line); ){
-        container.emplace_back( std::move(line) );
+    auto reader = LineReader{is};
+    for( std::string_view line; reader.next(line); ){
+        detail::append_line( container, line );
     }
 }
 
@@ -45,7 +79,9 @@ template<typename Container, typename Predicate>
 auto get_lines( std::istream& is, Predicate predicate ) -> Container
 {
     auto lines = Container{};
-    for( std::string line; getline(is, line); ){
+    auto reader = LineReader{is};
+    for( std::string_view view; reader.next(view); ){
+        auto line = std::string{view};
         if( predicate(line) ){
             lines.emplace_back( std::move(line) );
         }
@@ -56,7 +92,9 @@ auto get_lines( std::istream& is, Predicate predicate ) -> Container
 template<typename Container, typename Predicate>
 void get_lines( std::istream& is, Container& container, Predicate predicate )
 {
-    for( std::string line; getline(is, line); ){
+    auto reader = LineReader{is};
+    for( std::string_view view; reader.next(view); ){
+        auto line = std::string{view};
         if( predicate(line) ){
             container.emplace_back( std::move(line) );
         }
@@ -66,10 +104,123 @@ void get_lines( std::istream& is, Container& container, Predicate predicate )
 
 /* Sorting */
 /* ------------------------------------------------------------------------- */
+namespace detail
+{
+// Plain byte-wise string orderings: +1 ascending, -1 descending, 0 - anything else
+template<typename Predicate>
+struct string_order : std::integral_constant<int, 0> { };
+template<> struct string_order<std::less<std::string>> : std::integral_constant<int, 1> { };
+template<> struct string_order<std::less<std::string_view>> : std::integral_constant<int, 1> { };
+template<> struct string_order<std::less<>> : std::integral_constant<int, 1> { };
+template<> struct string_order<std::greater<std::string>> : std::integral_constant<int, -1> { };
+template<> struct string_order<std::greater<std::string_view>> : std::integral_constant<int, -1> { };
+template<> struct string_order<std::greater<>> : std::integral_constant<int, -1> { };
+
+template<typename T>
+struct is_byte_string : std::false_type { };
+template<> struct is_byte_string<std::string> : std::true_type { };
+template<> struct is_byte_string<std::string_view> : std::true_type { };
+
+template<typename Predicate, typename Value>
+constexpr int string_order_v = is_byte_string<Value>::value ? string_order<Predicate>::value : 0;
+
+constexpr std::ptrdiff_t multikey_insertion_threshold{16};
+
+// Byte at depth as compared by std::string, -1 past the end of the string
+inline auto byte_at( std::string_view s, std::size_t depth ) noexcept -> int
+{
+    return depth < s.size() ? static_cast<unsigned char>(s[depth]) : -1;
+}
+
+struct as_string_view
+{
+    template<typename T>
+    auto operator()( const T& t ) const noexcept -> std::string_view { return t; }
+};
+
+// Multikey quicksort (Bentley & Sedgewick). Partitions three ways on a single
+// byte and only moves on to the next byte within the equal partition, so a
+// prefix shared by many lines is examined once per line instead of once per
+// comparison. All lines in [first, last) share their first depth bytes.
+// project turns an element into the std::string_view it is ordered by.
+template<typename RandomIt, typename Projection = as_string_view>
+void multikey_quicksort( RandomIt first, RandomIt last, std::size_t depth,
+                         Projection project = {} )
+{
+    while( last - first > multikey_insertion_threshold ){
+        const auto a = byte_at(project(*first), depth);
+        const auto b = byte_at(project(*(first + (last - first) / 2)), depth);
+        const auto c = byte_at(project(*(last - 1)), depth);
+        const auto pivot = std::max( std::min(a, b), std::min(std::max(a, b), c) );
+
+        auto lt = first;
+        auto gt = last;
+        for( auto it = first; it < gt; ){
+            const auto byte = byte_at(project(*it), depth);
+            if( byte < pivot )
+                std::iter_swap(lt++, it++);
+            else if( pivot < byte )
+                std::iter_swap(it, --gt);
+            else
+                ++it;
+        }
+        if( pivot == -1 ){
+            multikey_quicksort(gt, last, depth, project);
+            return;     // the equal partition holds identical, ended lines
+        }
+        if( lt == first && gt == last ){
+            // Every line shares this byte - skip the whole common prefix in
+            // one pass instead of one pass per byte
+            const auto head = project(*first);
+            auto common = head.size() - depth;
+            for( auto it = first + 1; it != last && common != 0; ++it ){
+                const auto line = project(*it).substr(depth, common);
+                common = static_cast<std::size_t>( std::mismatch(line.cbegin(), line.cend(),
+                                                   head.cbegin() + depth).first - line.cbegin() );
+            }
+            depth += std::max<std::size_t>(common, 1);
+            continue;
+        }
+        multikey_quicksort(first, lt, depth, project);
+        multikey_quicksort(gt, last, depth, project);
+        first = lt;
+        last = gt;
+        ++depth;
+    }
+    for( auto it = first; it != last; ++it ){
+        auto value = std::move(*it);
+        const auto tail = project(value).substr(depth);
+        auto hole = it;
+        for( ; hole != first && tail < project(*(hole - 1)).substr(depth); --hole ){
+            *hole = std::move(*(hole - 1));
+        }
+        *hole = std::move(value);
+    }
+}
+
+// Sequential sort of a random-access range, byte-wise string orderings
+// go through the multikey quicksort
+template<typename RandomIt, typename Predicate>
+void sort_range( RandomIt first, RandomIt last, Predicate pred )
+{
+    constexpr auto order
+        = string_order_v<Predicate, typename std::iterator_traits<RandomIt>::value_type>;
+    if constexpr( order != 0 ){
+        multikey_quicksort(first, last, 0);
+        if constexpr( order < 0 ){
+            std::reverse(first, last);
+        }
+    }
+    else{
+        std::sort(first, last, pred);
+    }
+}
+} // namespace detail
+
 template<typename Container, typename Predicate>
 void sort_lines(Container& lines, Predicate pred)
 {
-    std::sort(lines.begin(), lines.end(), pred);
+    detail::sort_range(lines.begin(), lines.end(), pred);
 }
 
 template<typename T, typename Predicate>
@@ -78,6 +229,88 @@ void sort_lines( std::list<T>& lines, Predicate pred )
     lines.sort(pred);
 }
 
+// --- Parallel sort
+
+// Ranges shorter than this are not worth handing to another thread
+constexpr std::ptrdiff_t parallel_sort_threshold{1 << 14};
+
+namespace detail
+{
+// Merge two sorted ranges into out. The larger range is split at its median,
+// the other at the matching lower_bound, and both halves merge concurrently.
+template<typename InputIt, typename OutputIt, typename Predicate>
+void parallel_merge( InputIt first1, InputIt last1, InputIt first2, InputIt last2,
+                     OutputIt out, Predicate pred, unsigned threads )
+{
+    const auto size1 = std::distance(first1, last1);
+    const auto size2 = std::distance(first2, last2);
+    if( threads < 2 || size1 + size2 < parallel_sort_threshold ){
+        std::merge( std::make_move_iterator(first1), std::make_move_iterator(last1),
+                    std::make_move_iterator(first2), std::make_move_iterator(last2),
+                    out, pred );
+        return;
+    }
+    if( size1 < size2 ){
+        parallel_merge( first2, last2, first1, last1, out, pred, threads );
+        return;
+    }
+    const auto middle1 = first1 + size1 / 2;
+    // lower_bound would compare against a const value - wrapped predicates
+    // want both operands of the same type
+    const auto middle2 = std::partition_point( first2, last2,
+                            [&]( auto& element ){ return pred(element, *middle1); } );
+    const auto out_middle = out + std::distance(first1, middle1)
+                                + std::distance(first2, middle2);
+    auto left = std::async( std::launch::async,
+                            parallel_merge<InputIt,OutputIt,Predicate>,
+                            first1, middle1, first2, middle2, out, pred, threads / 2 );
+    parallel_merge( middle1, last1, middle2, last2, out_middle, pred, threads - threads / 2 );
+    left.get();
+}
+
+template<typename RandomIt, typename Predicate>
+void parallel_sort( RandomIt first, RandomIt last, Predicate pred, unsigned threads )
+{
+    const auto size = std::distance(first, last);
+    if( threads < 2 || size < parallel_sort_threshold ){
+        sort_range(first, last, pred);
+        return;
+    }
+    // Each half gets its own copy of the predicate - wrapped predicates are
+    // not required to be callable concurrently through a shared instance
+    const auto middle = first + size / 2;
+    auto left = std::async( std::launch::async,
+                            parallel_sort<RandomIt,Predicate>,
+                            first, middle, pred, threads / 2 );
+    parallel_sort( middle, last, pred, threads - threads / 2 );
+    left.get();
+
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    auto buffer = std::vector<value_type>( std::make_move_iterator(first),
+                                           std::make_move_iterator(last) );
+    parallel_merge( buffer.begin(), buffer.begin() + size / 2,
+                    buffer.begin() + size / 2, buffer.end(),
+                    first, pred, threads );
+}
+} // namespace detail
+
+// threads == 0 uses all of the hardware threads
+template<typename Container, typename Predicate>
+void sort_lines( Container& lines, Predicate pred, unsigned threads )
+{
+    if( threads == 0 ){
+        threads = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+    detail::parallel_sort( lines.begin(), lines.end(), pred, threads );
+}
+
+// Lists are not random-access - splitting them up is not worth it
+template<typename T, typename Predicate>
+void sort_lines( std::list<T>& lines, Predicate pred, unsigned /* threads */ )
+{
+    lines.sort(pred);
+}
+
 
 /* Composible predicates */
 /* ------------------------------------------------------------------------- */
@@ -168,6 +401,255 @@ auto operator&&( PredicateWrapper<WPred,WFunc>&& predicate,
 
 
 // --- Binary Predicates
+template<typename Predicate, typename Function>
+class BinaryPredicateWrapper;
+
+template<typename T>
+struct is_binary_predicate_wrapper : std::false_type { };
+template<typename Predicate, typename Function>
+struct is_binary_predicate_wrapper<BinaryPredicateWrapper<Predicate,Function>> : std::true_type { };
+template<typename T>
+constexpr bool is_binary_predicate_wrapper_v
+    = is_binary_predicate_wrapper<std::remove_cv_t<std::remove_reference_t<T>>>::value;
+
+// Whether the outermost transform takes a std::string_view as it is
+template<typename T>
+struct accepts_string_view : std::true_type { };
+template<typename Predicate, typename Function>
+struct accepts_string_view<BinaryPredicateWrapper<Predicate,Function>>
+    : std::is_invocable<Function&, std::string_view> { };
+
+// The operand after all of the wrapped transforms were applied to it, i.e.
+// what the innermost predicate ends up comparing
+template<typename Predicate, typename T>
+auto collation_key( Predicate& /* predicate */, T&& t ) -> std::decay_t<T>
+{
+    return std::forward<T>(t);
+}
+
+template<typename Predicate, typename Function, typename T>
+auto collation_key( BinaryPredicateWrapper<Predicate,Function>& predicate, T&& t )
+{
+    return predicate.key(std::forward<T>(t));
+}
+
+// The innermost, unwrapped predicate
+template<typename Predicate>
+auto base_predicate( Predicate& predicate ) -> Predicate&
+{
+    return predicate;
+}
+
+template<typename Predicate, typename Function>
+auto base_predicate( BinaryPredicateWrapper<Predicate,Function>& predicate ) -> auto&
+{
+    return predicate.base();
+}
+
+// --- Character-level transforms
+// Transforms that look at one character at a time. Called on a line they
+// return the transformed copy like any other transform. Chained on top of a
+// plain string order with wrap_binary_predicate() they are fused instead:
+// both operands are walked once, character by character, and the transformed
+// strings are never built.
+// A character-level transform declares a char_transform member type and a
+// cursor<Source> template - a Source that yields transformed characters.
+namespace detail
+{
+// Yields the bytes of a view, as unsigned char, and -1 past the end
+class char_source
+{
+public:
+    explicit char_source( std::string_view s ) noexcept
+        : m_first{s.data()}, m_last{s.data() + s.size()}
+        { }
+    auto next() noexcept -> int
+    {
+        return m_first != m_last ? static_cast<unsigned char>(*m_first++) : -1;
+    }
+private:
+    const char* m_first;
+    const char* m_last;
+};
+
+constexpr auto is_blank( int ch ) noexcept -> bool
+{
+    return ch == ' ' || ch == '\t' || ch == '\n';
+}
+
+constexpr auto is_alnum( int ch ) noexcept -> bool
+{
+    return (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
+
+// Runs a cursor to the end - the eager form of a character-level transform
+template<typename Cursor>
+auto materialize( std::string_view s ) -> std::string
+{
+    auto result = std::string{};
+    result.reserve(s.size());
+    auto cursor = Cursor{s};
+    for( auto ch = cursor.next(); ch >= 0; ch = cursor.next() ){
+        result.push_back( static_cast<char>(ch) );
+    }
+    return result;
+}
+
+template<typename T, typename = void>
+struct is_char_transform : std::false_type { };
+template<typename T>
+struct is_char_transform<T, std::void_t<typename T::char_transform>> : std::true_type { };
+} // namespace detail
+
+// Treats lowercase ASCII letters as uppercase
+struct FoldCase
+{
+    using char_transform = std::true_type;
+
+    template<typename Source>
+    class cursor
+    {
+    public:
+        explicit cursor( std::string_view s ) noexcept : m_source{s} { }
+        auto next() noexcept -> int
+        {
+            const auto ch = m_source.next();
+            return ch >= 'a' && ch <= 'z' ? ch - ('a' - 'A') : ch;
+        }
+    private:
+        Source m_source;
+    };
+
+    auto operator()( std::string_view s ) const -> std::string
+    {
+        return detail::materialize<cursor<detail::char_source>>(s);
+    }
+};
+
+// Drops the blanks at the start of a line
+struct SkipLeadingBlanks
+{
+    using char_transform = std::true_type;
+
+    template<typename Source>
+    class cursor
+    {
+    public:
+        explicit cursor( std::string_view s ) noexcept : m_source{s} { }
+        auto next() noexcept -> int
+        {
+            auto ch = m_source.next();
+            if( m_leading ){
+                while( detail::is_blank(ch) ){
+                    ch = m_source.next();
+                }
+                m_leading = false;
+            }
+            return ch;
+        }
+    private:
+        Source m_source;
+        bool m_leading{true};
+    };
+
+    auto operator()( std::string_view s ) const -> std::string
+    {
+        return detail::materialize<cursor<detail::char_source>>(s);
+    }
+};
+
+// Keeps only blanks and alphanumeric characters
+struct DictionaryOrder
+{
+    using char_transform = std::true_type;
+
+    template<typename Source>
+    class cursor
+    {
+    public:
+        explicit cursor( std::string_view s ) noexcept : m_source{s} { }
+        auto next() noexcept -> int
+        {
+            auto ch = m_source.next();
+            while( ch >= 0 && !detail::is_blank(ch) && !detail::is_alnum(ch) ){
+                ch = m_source.next();
+            }
+            return ch;
+        }
+    private:
+        Source m_source;
+    };
+
+    auto operator()( std::string_view s ) const -> std::string
+    {
+        return detail::materialize<cursor<detail::char_source>>(s);
+    }
+};
+
+inline constexpr FoldCase fold_case{};
+inline constexpr SkipLeadingBlanks skip_leading_blanks{};
+inline constexpr DictionaryOrder dictionary_order{};
+
+namespace detail
+{
+// A binary predicate made of character-level transforms only, wrapped around
+// a plain string order. cursor stacks the transforms on top of Source in the
+// order they are applied - the outermost wrapper's transform first.
+template<typename Predicate, typename Source>
+struct fused_chain
+{
+    static constexpr int order = string_order<Predicate>::value;
+    static constexpr bool value = order != 0;
+    using cursor = Source;
+};
+
+template<typename Predicate, typename Function, typename Source,
+         bool = is_char_transform<std::decay_t<Function>>::value>
+struct fused_link
+{
+    static constexpr int order = 0;
+    static constexpr bool value = false;
+    using cursor = Source;
+};
+
+template<typename Predicate, typename Function, typename Source>
+struct fused_link<Predicate, Function, Source, true>
+    : fused_chain<std::decay_t<Predicate>,
+                  typename std::decay_t<Function>::template cursor<Source>>
+{ };
+
+template<typename Predicate, typename Function, typename Source>
+struct fused_chain<BinaryPredicateWrapper<Predicate,Function>, Source>
+    : fused_link<Predicate, Function, Source>
+{ };
+
+template<typename Predicate>
+constexpr bool is_fused_v = fused_chain<std::decay_t<Predicate>, char_source>::value;
+
+template<typename Predicate>
+using fused_cursor_t = typename fused_chain<std::decay_t<Predicate>, char_source>::cursor;
+
+// One pass over both operands, stops at the first transformed character
+// that differs
+template<typename Predicate>
+auto fused_compare( std::string_view lhs, std::string_view rhs ) noexcept -> bool
+{
+    constexpr auto order = fused_chain<std::decay_t<Predicate>, char_source>::order;
+    auto lcursor = fused_cursor_t<Predicate>{lhs};
+    auto rcursor = fused_cursor_t<Predicate>{rhs};
+    for( ;; ){
+        const auto lch = lcursor.next();
+        const auto rch = rcursor.next();
+        if( lch != rch ){
+            return order > 0 ? lch < rch : lch > rch;
+        }
+        if( lch < 0 ){
+            return false;
+        }
+    }
+}
+} // namespace detail
+
 template<typename Predicate, typename Function>
 class BinaryPredicateWrapper : public PredicateBase<BinaryPredicateWrapper<Predicate,Function>>
 {
@@ -180,10 +662,31 @@ public:
         template<typename T>
         auto operator()( T&& lhs, T&& rhs ) -> bool
         {
-            return m_predicate( m_function(std::forward<T>(lhs)),
-                                m_function(std::forward<T>(rhs))
-                              );
+            if constexpr( detail::is_fused_v<BinaryPredicateWrapper>
+                          && std::is_convertible_v<T, std::string_view> ){
+                return detail::fused_compare<BinaryPredicateWrapper>( lhs, rhs );
+            }
+            else{
+                return m_predicate( m_function(std::forward<T>(lhs)),
+                                    m_function(std::forward<T>(rhs))
+                                  );
+            }
+        }
+
+        template<typename T>
+        auto key( T&& t )
+        {
+            if constexpr( detail::is_fused_v<BinaryPredicateWrapper>
+                          && std::is_convertible_v<T, std::string_view> ){
+                // One pass and one string for the whole chain
+                return detail::materialize<detail::fused_cursor_t<BinaryPredicateWrapper>>( t );
+            }
+            else{
+                return collation_key( m_predicate, m_function(std::forward<T>(t)) );
+            }
         }
+
+        auto base() -> auto& { return base_predicate(m_predicate); }
 private:
     Predicate m_predicate;
     Function m_function;
@@ -227,10 +730,221 @@ using BiPred = PredicateBase<BinaryPredicateWrapper<Predicate,Function>>;
 /* ------------------------------------------------------------------------- */
 
 
+/* Sorting on precomputed keys (decorate-sort-undecorate) */
+/* ------------------------------------------------------------------------- */
+namespace detail
+{
+// String keys live in one arena and are compared as views - map the common
+// std::string predicates onto their std::string_view counterparts
+template<typename Predicate>
+auto view_predicate( Predicate& predicate ) -> Predicate&
+{
+    return predicate;
+}
+inline auto view_predicate( std::less<std::string>& ) { return std::less<std::string_view>{}; }
+inline auto view_predicate( std::greater<std::string>& ) { return std::greater<std::string_view>{}; }
+
+// Rearrange lines so that lines[i] becomes the old lines[order[i]]
+template<typename Container, typename = void>
+struct has_permute : std::false_type { };
+template<typename Container>
+struct has_permute<Container, std::void_t<decltype(
+    std::declval<Container&>().permute(std::declval<const std::vector<std::size_t>&>()) )>>
+    : std::true_type { };
+
+template<typename Container>
+void apply_order( Container& lines, const std::vector<std::size_t>& order )
+{
+    if constexpr( has_permute<Container>::value ){
+        lines.permute(order);
+    }
+    else{
+        auto positions = std::vector<typename Container::iterator>{};
+        positions.reserve(order.size());
+        for( auto it = lines.begin(); it != lines.end(); ++it ){
+            positions.push_back(it);
+        }
+        auto sorted = Container{};
+        sorted.reserve(order.size());
+        for( auto index : order ){
+            sorted.emplace_back( std::move(*positions[index]) );
+        }
+        lines = std::move(sorted);
+    }
+}
+
+template<typename T>
+void apply_order( std::list<T>& lines, const std::vector<std::size_t>& order )
+{
+    auto positions = std::vector<typename std::list<T>::iterator>{};
+    positions.reserve(order.size());
+    for( auto it = lines.begin(); it != lines.end(); ++it ){
+        positions.push_back(it);
+    }
+    auto sorted = std::list<T>{};
+    for( auto index : order ){
+        sorted.splice( sorted.end(), lines, positions[index] );
+    }
+    lines.swap(sorted);
+}
+} // namespace detail
+
+namespace detail
+{
+// Sorts line indices on project(index), the key of each line. Byte-wise
+// orders of string keys go through the multikey quicksort.
+template<typename Compare, typename Projection>
+void sort_indices( std::vector<std::size_t>& order, Compare& compare, Projection project )
+{
+    constexpr auto direction
+        = std::is_convertible_v<std::invoke_result_t<Projection&, std::size_t>, std::string_view>
+          ? string_order<std::decay_t<Compare>>::value : 0;
+    if constexpr( direction != 0 ){
+        multikey_quicksort( order.begin(), order.end(), 0, project );
+        if constexpr( direction < 0 ){
+            std::reverse( order.begin(), order.end() );
+        }
+    }
+    else{
+        std::sort( order.begin(), order.end(),
+            [&]( std::size_t lhs, std::size_t rhs ){
+                return compare(project(lhs), project(rhs));
+            } );
+    }
+}
+
+// A key computed from a temporary copy of the line must not point into it
+inline auto own_key( std::string_view key ) -> std::string { return std::string{key}; }
+template<typename Key>
+auto own_key( Key&& key ) -> std::decay_t<Key> { return std::forward<Key>(key); }
+} // namespace detail
+
+// Applies the transforms of a wrapped binary predicate once per line instead
+// of twice per comparison, then sorts line indices on the precomputed keys.
+// Predicates that do not transform their operands are sorted directly.
+template<typename Container, typename Predicate>
+void sort_lines_by_key( Container& lines, Predicate pred )
+{
+    if constexpr( !is_binary_predicate_wrapper_v<Predicate> ){
+        sort_lines(lines, pred);
+    }
+    else{
+        using Line = std::decay_t<decltype(*lines.begin())>;
+        // Views are turned into strings for transforms that want std::string
+        constexpr auto copies_lines = std::is_same_v<Line, std::string_view>
+                                      && !accepts_string_view<Predicate>::value;
+        const auto key_of = [&pred]( auto&& line ){
+            if constexpr( copies_lines ){
+                return detail::own_key( collation_key( pred, std::string{line} ) );
+            }
+            else{
+                return collation_key( pred, line );
+            }
+        };
+        using Key = decltype( key_of(*lines.begin()) );
+        auto&& compare = detail::view_predicate( base_predicate(pred) );
+        using Compare = decltype(compare);
+        auto order = std::vector<std::size_t>{};
+
+        if constexpr( std::is_same_v<Key, std::string_view> && !copies_lines ){
+            // The keys are views into the lines themselves (jam::KeyField).
+            // Lines stay where they are until the order is applied, so the
+            // position of the key within every line is all that is kept.
+            auto keys = std::vector<std::string_view>{};
+            for( auto&& line : lines ){
+                keys.push_back( key_of(line) );
+            }
+            order.resize(keys.size());
+            std::iota(order.begin(), order.end(), std::size_t{0});
+            detail::sort_indices( order, compare, [&]( std::size_t i ){ return keys[i]; } );
+        }
+        else if constexpr( std::is_convertible_v<const Key&, std::string_view>
+                           && std::is_invocable_r_v<bool, Compare, std::string_view, std::string_view> ){
+            auto arena = std::string{};
+            auto offsets = std::vector<std::size_t>{0};
+            for( auto&& line : lines ){
+                if constexpr( detail::is_fused_v<Predicate> ){
+                    // Character-level transforms write the key straight
+                    // into the arena, no intermediate strings
+                    auto cursor = detail::fused_cursor_t<Predicate>{ std::string_view{line} };
+                    for( auto ch = cursor.next(); ch >= 0; ch = cursor.next() ){
+                        arena.push_back( static_cast<char>(ch) );
+                    }
+                }
+                else{
+                    arena += key_of(line);
+                }
+                offsets.push_back(arena.size());
+            }
+            order.resize(offsets.size() - 1);
+            std::iota(order.begin(), order.end(), std::size_t{0});
+            detail::sort_indices( order, compare, [&]( std::size_t i ){
+                return std::string_view( arena.data() + offsets[i], offsets[i+1] - offsets[i] );
+            });
+        }
+        else{
+            auto keys = std::vector<Key>{};
+            for( auto&& line : lines ){
+                keys.push_back( key_of(line) );
+            }
+            order.resize(keys.size());
+            std::iota(order.begin(), order.end(), std::size_t{0});
+            detail::sort_indices( order, compare, [&]( std::size_t i ) -> const Key& { return keys[i]; } );
+        }
+        detail::apply_order( lines, order );
+    }
+}
+/* ------------------------------------------------------------------------- */
+
+
 /* Iterators */
 /* ------------------------------------------------------------------------- */
 
+namespace detail
+{
+// Holds a function object so that iterators carrying it stay assignable,
+// even when the function object (a lambda, say) is not
+template<typename Function>
+class function_box
+{
+public:
+    function_box() = default;
+    explicit function_box( Function function ) : m_function{std::move(function)} { }
+    function_box( const function_box& ) = default;
+    function_box( function_box&& ) = default;
+    function_box& operator=( const function_box& other )
+    {
+        if( this != &other ){
+            other.m_function ? (void)m_function.emplace(*other.m_function) : m_function.reset();
+        }
+        return *this;
+    }
+    function_box& operator=( function_box&& other )
+    {
+        if( this != &other ){
+            other.m_function ? (void)m_function.emplace(std::move(*other.m_function)) : m_function.reset();
+        }
+        return *this;
+    }
+    template<typename... Args>
+    decltype(auto) operator()( Args&&... args ) const { return (*m_function)(std::forward<Args>(args)...); }
+    const Function& get() const { return *m_function; }
+private:
+    std::optional<Function> m_function{};
+};
+
+// The weaker of the base iterator's category and random access
+template<typename Iterator>
+using transform_category = std::conditional_t<
+    std::is_base_of_v<std::random_access_iterator_tag,
+                      typename std::iterator_traits<Iterator>::iterator_category>,
+    std::random_access_iterator_tag,
+    typename std::iterator_traits<Iterator>::iterator_category>;
+} // namespace detail
+
 // --- transform_iterator
+// Applies the function on every dereference. Moves the way the base iterator
+// does, so a random-access base makes a random-access transform_iterator.
 template<typename Iterator
         ,typename UnaryFunction
         ,typename Reference
@@ -244,32 +958,69 @@ public:
     using reference = Reference;
     using pointer = typename std::iterator_traits<Iterator>::pointer;
     using difference_type = typename std::iterator_traits<Iterator>::difference_type;
-    using iterator_category = std::input_iterator_tag;
+    using iterator_category = detail::transform_category<Iterator>;
 
+    transform_iterator() = default;
     transform_iterator( const Iterator& it, UnaryFunction function )
-        : m_iterator{it}, m_function{function}
+        : m_iterator{it}, m_function{std::move(function)}
         { }
-    UnaryFunction functor() const { return m_function; }
+    UnaryFunction functor() const { return m_function.get(); }
     const Iterator& base() const { return m_iterator; }
     reference operator*() const { return m_function(*m_iterator); }
+    reference operator[]( difference_type n ) const { return m_function(m_iterator[n]); }
     transform_iterator& operator++()
     {
         ++m_iterator;
         return *this;
     }
+    transform_iterator operator++(int)
+    {
+        auto rv = *this;
+        ++m_iterator;
+        return rv;
+    }
     transform_iterator& operator--()
     {
         --m_iterator;
         return *this;
     }
+    transform_iterator operator--(int)
+    {
+        auto rv = *this;
+        --m_iterator;
+        return rv;
+    }
+    transform_iterator& operator+=( difference_type n )
+    {
+        m_iterator += n;
+        return *this;
+    }
+    transform_iterator& operator-=( difference_type n )
+    {
+        m_iterator -= n;
+        return *this;
+    }
+    friend transform_iterator operator+( transform_iterator it, difference_type n ) { return it += n; }
+    friend transform_iterator operator+( difference_type n, transform_iterator it ) { return it += n; }
+    friend transform_iterator operator-( transform_iterator it, difference_type n ) { return it -= n; }
+    friend difference_type operator-( const transform_iterator& lhs, const transform_iterator& rhs )
+    { return lhs.m_iterator - rhs.m_iterator; }
 
     bool operator==(const transform_iterator& other) const noexcept
     { return m_iterator == other.m_iterator; }
     bool operator!=(const transform_iterator& other) const noexcept
     { return !(*this == other); }
+    bool operator<(const transform_iterator& other) const noexcept
+    { return m_iterator < other.m_iterator; }
+    bool operator>(const transform_iterator& other) const noexcept
+    { return other < *this; }
+    bool operator<=(const transform_iterator& other) const noexcept
+    { return !(other < *this); }
+    bool operator>=(const transform_iterator& other) const noexcept
+    { return !(*this < other); }
 private:
-    Iterator m_iterator;
-    UnaryFunction m_function;
+    Iterator m_iterator{};
+    detail::function_box<UnaryFunction> m_function{};
 };
 
 template<typename Iterator, typename UnaryFunction>
@@ -279,6 +1030,73 @@ auto make_transform_iterator(const Iterator& it, UnaryFunction ufunc)
 }
 
 
+// --- caching_transform_iterator
+// Opt-in variant remembering the value computed for the current position, so
+// algorithms that read the same position more than once - std::copy_if tests
+// *first and then copies it - call the function only once per position.
+// operator* returns a reference into the iterator itself, so it is an input
+// iterator whatever the base is: the reference is valid until the iterator
+// is incremented, copied over or destroyed. Algorithms that need a forward
+// iterator (std::lower_bound, std::sort, std::max_element) take a
+// transform_iterator instead.
+template<typename Iterator
+        ,typename UnaryFunction
+        ,typename Value
+            = std::decay_t<std::result_of_t<const UnaryFunction(typename std::iterator_traits<Iterator>::reference)>>
+        >
+class caching_transform_iterator
+{
+public:
+    using value_type = Value;
+    using reference = const Value&;
+    using pointer = const Value*;
+    using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+    using iterator_category = std::input_iterator_tag;
+
+    caching_transform_iterator() = default;
+    caching_transform_iterator( const Iterator& it, UnaryFunction function )
+        : m_iterator{it}, m_function{std::move(function)}
+        { }
+    UnaryFunction functor() const { return m_function.get(); }
+    const Iterator& base() const { return m_iterator; }
+    reference operator*() const
+    {
+        if( !m_cache ){
+            m_cache.emplace( m_function(*m_iterator) );
+        }
+        return *m_cache;
+    }
+    pointer operator->() const { return &**this; }
+    caching_transform_iterator& operator++()
+    {
+        ++m_iterator;
+        m_cache.reset();
+        return *this;
+    }
+    caching_transform_iterator operator++(int)
+    {
+        auto rv = *this;
+        ++*this;
+        return rv;
+    }
+
+    bool operator==(const caching_transform_iterator& other) const noexcept
+    { return m_iterator == other.m_iterator; }
+    bool operator!=(const caching_transform_iterator& other) const noexcept
+    { return !(*this == other); }
+private:
+    Iterator m_iterator{};
+    detail::function_box<UnaryFunction> m_function{};
+    mutable std::optional<Value> m_cache{};
+};
+
+template<typename Iterator, typename UnaryFunction>
+auto make_caching_transform_iterator(const Iterator& it, UnaryFunction ufunc)
+{
+    return caching_transform_iterator<Iterator,UnaryFunction>(it,ufunc);
+}
+
+
 /* ------------------------------------------------------------------------- */
 
 
@@ -0,0 +1,55 @@
+#ifndef JAM_KEY_FIELD_INCLUDED_HPP_
+#define JAM_KEY_FIELD_INCLUDED_HPP_
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Sort key fields */
+/* ------------------------------------------------------------------------- */
+// The part of a line selected by a sort(1) style key definition,
+// POS1[,POS2] with POS being F[.C] - field F, character C of it, both
+// counted from 1. POS2 defaults to the end of the line, a C of 0 in POS2 to
+// the end of its field.
+// Fields are separated by the separator character if there is one. Without
+// it every field is a run of non-blanks together with the blanks before it.
+//
+// Called on a line it returns a view of the key within that line, so wrapped
+// around a predicate with wrap_binary_predicate() the key is located once
+// per line by sort_lines_by_key() and compared in place.
+class KeyField
+{
+public:
+    // Throws std::invalid_argument for a malformed definition
+    explicit KeyField( std::string_view definition,
+                       std::optional<char> separator = std::nullopt );
+
+    auto operator()( std::string_view line ) const noexcept -> std::string_view;
+
+private:
+    // Offset of the first character of field, line.size() if there is none
+    auto field_begin( std::string_view line, std::size_t field ) const noexcept -> std::size_t;
+    // Offset just past the field starting at begin
+    auto field_end( std::string_view line, std::size_t begin ) const noexcept -> std::size_t;
+
+    // m_begin_char is zero based, m_end_char counts the characters of the
+    // end field that are part of the key, 0 meaning all of them
+    std::size_t m_begin_field{0};
+    std::size_t m_begin_char{0};
+    std::optional<std::size_t> m_end_field{};
+    std::size_t m_end_char{0};
+    std::optional<char> m_separator;
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_KEY_FIELD_INCLUDED_HPP_ */
@@ -0,0 +1,194 @@
+#ifndef JAM_LINE_BUFFER_INCLUDED_HPP_
+#define JAM_LINE_BUFFER_INCLUDED_HPP_
+
+#include "jam/jam.hpp"
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Arena-backed line container */
+/* ------------------------------------------------------------------------- */
+// Stores the bytes of all lines back to back in large chunks plus a compact
+// (chunk, offset, length) index entry per line - 12 bytes per line instead of
+// a std::string and, past the SSO limit, a heap block of its own.
+// Lines are handed out as std::string_view. Sorting and permuting only move
+// index entries around, the line bytes never move once stored.
+class LineBuffer
+{
+    struct Entry
+    {
+        std::uint32_t chunk;
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+public:
+    using value_type = std::string_view;
+    using size_type = std::size_t;
+    using stores_line_bytes = std::true_type;
+
+    static constexpr std::size_t chunk_size{std::size_t{1} << 20};
+
+    class const_iterator
+    {
+    public:
+        using value_type = std::string_view;
+        using reference = std::string_view;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::random_access_iterator_tag;
+
+        const_iterator() noexcept = default;
+        const_iterator( const LineBuffer* lines, size_type index ) noexcept
+            : m_lines{lines}, m_index{index}
+            { }
+        reference operator*() const noexcept { return (*m_lines)[m_index]; }
+        reference operator[]( difference_type n ) const noexcept
+        { return (*m_lines)[m_index + n]; }
+        const_iterator& operator++() noexcept { ++m_index; return *this; }
+        const_iterator operator++(int) noexcept { auto rv = *this; ++m_index; return rv; }
+        const_iterator& operator--() noexcept { --m_index; return *this; }
+        const_iterator operator--(int) noexcept { auto rv = *this; --m_index; return rv; }
+        const_iterator& operator+=( difference_type n ) noexcept { m_index += n; return *this; }
+        const_iterator& operator-=( difference_type n ) noexcept { m_index -= n; return *this; }
+        friend const_iterator operator+( const_iterator it, difference_type n ) noexcept
+        { return it += n; }
+        friend const_iterator operator+( difference_type n, const_iterator it ) noexcept
+        { return it += n; }
+        friend const_iterator operator-( const_iterator it, difference_type n ) noexcept
+        { return it -= n; }
+        friend difference_type operator-( const const_iterator& lhs, const const_iterator& rhs ) noexcept
+        { return static_cast<difference_type>(lhs.m_index) - static_cast<difference_type>(rhs.m_index); }
+        bool operator==( const const_iterator& other ) const noexcept { return m_index == other.m_index; }
+        bool operator!=( const const_iterator& other ) const noexcept { return m_index != other.m_index; }
+        bool operator<( const const_iterator& other ) const noexcept { return m_index < other.m_index; }
+        bool operator>( const const_iterator& other ) const noexcept { return m_index > other.m_index; }
+        bool operator<=( const const_iterator& other ) const noexcept { return m_index <= other.m_index; }
+        bool operator>=( const const_iterator& other ) const noexcept { return m_index >= other.m_index; }
+    private:
+        const LineBuffer* m_lines{nullptr};
+        size_type m_index{0};
+    };
+    using iterator = const_iterator;
+
+    void emplace_back( std::string_view line );
+    void push_back( std::string_view line ) { emplace_back(line); }
+    void reserve( size_type lines ) { m_index.reserve(lines); }
+    void clear() noexcept;
+
+    auto size() const noexcept -> size_type { return m_index.size(); }
+    auto empty() const noexcept -> bool { return m_index.empty(); }
+    // Bytes of line data stored, newlines not included
+    auto bytes() const noexcept -> std::size_t { return m_bytes; }
+
+    auto operator[]( size_type n ) const noexcept -> std::string_view { return view(m_index[n]); }
+    auto front() const noexcept -> std::string_view { return view(m_index.front()); }
+    auto back() const noexcept -> std::string_view { return view(m_index.back()); }
+
+    auto begin() const noexcept { return const_iterator{this, 0}; }
+    auto end() const noexcept { return const_iterator{this, size()}; }
+    auto cbegin() const noexcept { return begin(); }
+    auto cend() const noexcept { return end(); }
+
+    // Line i becomes the old line order[i]
+    void permute( const std::vector<size_type>& order );
+
+    template<typename Predicate>
+    void sort( Predicate pred );
+
+    template<typename Predicate>
+    void sort( Predicate pred, unsigned threads );
+
+    // Writes every line followed by '\n', gathered into large blocks
+    void write( std::ostream& os ) const;
+
+private:
+    auto view( const Entry& entry ) const noexcept -> std::string_view
+    {
+        return { m_chunks[entry.chunk].get() + entry.offset, entry.length };
+    }
+
+    template<typename Predicate>
+    auto entry_compare( Predicate& pred )
+    {
+        return [this, vpred = detail::view_predicate(pred)]( const Entry& lhs, const Entry& rhs ) mutable {
+            return vpred( view(lhs), view(rhs) );
+        };
+    }
+
+    std::vector<std::unique_ptr<char[]>> m_chunks{};
+    std::size_t m_chunk_capacity{0};
+    std::size_t m_chunk_used{0};
+    std::size_t m_bytes{0};
+    std::vector<Entry> m_index{};
+};
+
+template<typename Predicate>
+void LineBuffer::sort( Predicate pred )
+{
+    if constexpr( is_binary_predicate_wrapper_v<Predicate> ){
+        // Transforms are applied once per line, the keys decide the order
+        sort_lines_by_key(*this, pred);
+    }
+    else if constexpr( detail::string_order_v<Predicate, std::string_view> != 0 ){
+        detail::multikey_quicksort( m_index.begin(), m_index.end(), 0,
+            [this]( const Entry& entry ){ return view(entry); } );
+        if constexpr( detail::string_order_v<Predicate, std::string_view> < 0 ){
+            std::reverse( m_index.begin(), m_index.end() );
+        }
+    }
+    else{
+        std::sort( m_index.begin(), m_index.end(), entry_compare(pred) );
+    }
+}
+
+template<typename Predicate>
+void LineBuffer::sort( Predicate pred, unsigned threads )
+{
+    if constexpr( is_binary_predicate_wrapper_v<Predicate> ){
+        sort_lines_by_key(*this, pred);
+    }
+    else{
+        if( threads == 0 ){
+            threads = std::max( std::thread::hardware_concurrency(), 1u );
+        }
+        detail::parallel_sort( m_index.begin(), m_index.end(), entry_compare(pred), threads );
+    }
+}
+
+template<typename Predicate>
+void sort_lines( LineBuffer& lines, Predicate pred )
+{
+    lines.sort(pred);
+}
+
+template<typename Predicate>
+void sort_lines( LineBuffer& lines, Predicate pred, unsigned threads )
+{
+    lines.sort(pred, threads);
+}
+
+inline auto operator<<( std::ostream& os, const LineBuffer& lines ) -> std::ostream&
+{
+    lines.write(os);
+    return os;
+}
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_LINE_BUFFER_INCLUDED_HPP_ */
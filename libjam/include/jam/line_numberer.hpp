@@ -0,0 +1,79 @@
+#ifndef JAM_LINE_NUMBERER_INCLUDED_HPP_
+#define JAM_LINE_NUMBERER_INCLUDED_HPP_
+
+#include <vector>
+#include <cstddef>
+
+#include <sys/uio.h>
+
+
+namespace jam
+{
+
+
+/* Block-based line numbering */
+/* ------------------------------------------------------------------------- */
+// Copies file descriptors to an output descriptor, putting "N.\t" in front of
+// every line, or only in front of the non-empty ones.
+// The input is read in large blocks and scanned with find_newline(). The
+// number is kept as ASCII digits and incremented in place. Prefixes and short
+// lines are gathered in a staging buffer, long lines stay in the read buffer,
+// and all of it goes out together with writev(2).
+// Numbering carries on from one number() call to the next; every input
+// starts at the beginning of a line.
+class LineNumberer
+{
+public:
+    enum class Mode
+    {
+        all,        // cat -n
+        nonblank    // cat -b
+    };
+
+    static constexpr std::size_t default_block_size{1 << 20};
+
+    explicit LineNumberer( int out_fd, Mode mode = Mode::all, std::size_t first = 1,
+                           std::size_t block_size = default_block_size );
+
+    // Reads in_fd from its current offset to the end.
+    // Throws std::runtime_error if reading or writing fails.
+    void number( int in_fd );
+
+    // The number the next numbered line gets
+    auto next_number() const -> std::size_t;
+
+private:
+    // Room for the digits of any std::size_t, then ".\t"
+    static constexpr std::size_t counter_size{24};
+    static constexpr std::size_t counter_digits_end{counter_size - 2};
+    // Iovecs per writev(), the IOV_MAX of Linux
+    static constexpr std::size_t max_iovecs{1024};
+    static constexpr std::size_t staging_size{std::size_t{1} << 18};
+    // Shorter lines are cheaper to copy than to pass as iovecs of their own
+    static constexpr std::size_t copy_limit{512};
+
+    void increment() noexcept;
+    void add_prefix();
+    void add_segment( const char* first, const char* last );
+    void stage( const char* data, std::size_t length );
+    void add_iovec( const char* data, std::size_t length );
+    void flush();
+
+    int m_out_fd;
+    Mode m_mode;
+    std::vector<char> m_block;
+    // The current number, right-aligned in front of ".\t"
+    char m_counter[counter_size];
+    std::size_t m_counter_begin;
+    // Prefixes and short lines of the pending writev()
+    std::vector<char> m_staging;
+    std::size_t m_staged{0};
+    std::vector<iovec> m_iovecs{};
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_LINE_NUMBERER_INCLUDED_HPP_ */
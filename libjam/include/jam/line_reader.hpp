@@ -0,0 +1,52 @@
+#ifndef JAM_LINE_READER_INCLUDED_HPP_
+#define JAM_LINE_READER_INCLUDED_HPP_
+
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Block-based line reader */
+/* ------------------------------------------------------------------------- */
+// First '\n' in [first, last), or last if there is none. Scans with AVX2 or
+// SSE2 where the CPU has it, memchr otherwise.
+auto find_newline( const char* first, const char* last ) noexcept -> const char*;
+
+// Reads a stream in large blocks and splits it into lines in place.
+// The views handed out by next() point into the reader's buffer and stay
+// valid only until the following call to next(). The trailing '\n' is not
+// part of a line, same as with getline().
+class LineReader
+{
+public:
+    static constexpr std::size_t default_block_size{1 << 20};
+
+    explicit LineReader( std::istream& is, std::size_t block_size = default_block_size );
+
+    auto next( std::string_view& line ) -> bool;
+    auto bytes_read() const noexcept -> std::size_t { return m_bytes_read; }
+
+private:
+    auto fill() -> bool;
+
+    std::istream& m_is;
+    std::vector<char> m_buffer;
+    std::size_t m_begin{0};     // start of the current line
+    std::size_t m_scanned{0};   // bytes from m_begin known not to hold a '\n'
+    std::size_t m_end{0};       // end of valid data
+    std::size_t m_bytes_read{0};
+    bool m_eof{false};
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_LINE_READER_INCLUDED_HPP_ */
@@ -0,0 +1,75 @@
+#ifndef JAM_LINE_WRITER_INCLUDED_HPP_
+#define JAM_LINE_WRITER_INCLUDED_HPP_
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <chrono>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Buffered bulk output */
+/* ------------------------------------------------------------------------- */
+// Gathers lines into one large buffer and hands it to write(2) whenever it
+// fills up - a handful of syscalls instead of an ostream insert per line.
+// Writes to a file, or to the standard output for an empty file name.
+// Whatever is still buffered is written by flush() or the destructor; only
+// flush() reports errors.
+class LineWriter
+{
+public:
+    static constexpr std::size_t default_buffer_size{1 << 20};
+
+    explicit LineWriter( const std::string& fname = {},
+                         std::size_t buffer_size = default_buffer_size );
+    LineWriter( const LineWriter& ) = delete;
+    LineWriter& operator=( const LineWriter& ) = delete;
+    LineWriter( LineWriter&& other ) noexcept;
+    LineWriter& operator=( LineWriter&& other ) noexcept;
+    ~LineWriter();
+
+    // Writes line followed by '\n'
+    void write_line( std::string_view line );
+    // Writes bytes as they are
+    void write( std::string_view bytes );
+    void flush();
+
+    template<typename Container>
+    void write_lines( const Container& lines )
+    {
+        for( const auto& line : lines ){
+            write_line(line);
+        }
+    }
+
+    auto bytes_written() const noexcept -> std::size_t { return m_bytes_written; }
+    // Throughput since the writer was created, up to the last flush
+    auto bytes_per_second() const noexcept -> double;
+    void report( std::ostream& os ) const;
+
+private:
+    void write_all( const char* data, std::size_t size );
+    void close() noexcept;
+
+    int m_fd{-1};
+    bool m_owns_fd{false};
+    std::string m_name;
+    std::unique_ptr<char[]> m_buffer;
+    std::size_t m_capacity;
+    std::size_t m_used{0};
+    std::size_t m_bytes_written{0};
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_last_flush;
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_LINE_WRITER_INCLUDED_HPP_ */
@@ -0,0 +1,157 @@
+#ifndef JAM_MAPPED_LINES_INCLUDED_HPP_
+#define JAM_MAPPED_LINES_INCLUDED_HPP_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iterator>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Memory-mapped line source */
+/* ------------------------------------------------------------------------- */
+// Maps a whole file read-only and indexes the start of every line once.
+// Lines are handed out as std::string_view into the mapping - nothing is
+// copied, so the views are valid only as long as the MappedLines object lives.
+// The trailing '\n' is not part of a line, same as with getline().
+// Only regular files can be mapped, and only ones whose size can be trusted -
+// pipes, devices and the like of /proc are left to streaming.
+class MappedLines
+{
+public:
+    using value_type = std::string_view;
+    using size_type = std::size_t;
+
+    class const_iterator
+    {
+    public:
+        using value_type = std::string_view;
+        using reference = std::string_view;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::random_access_iterator_tag;
+
+        const_iterator() noexcept = default;
+        const_iterator( const MappedLines* lines, size_type index ) noexcept
+            : m_lines{lines}, m_index{index}
+            { }
+        reference operator*() const noexcept { return (*m_lines)[m_index]; }
+        reference operator[]( difference_type n ) const noexcept
+        { return (*m_lines)[m_index + n]; }
+        const_iterator& operator++() noexcept { ++m_index; return *this; }
+        const_iterator operator++(int) noexcept { auto rv = *this; ++m_index; return rv; }
+        const_iterator& operator--() noexcept { --m_index; return *this; }
+        const_iterator operator--(int) noexcept { auto rv = *this; --m_index; return rv; }
+        const_iterator& operator+=( difference_type n ) noexcept { m_index += n; return *this; }
+        const_iterator& operator-=( difference_type n ) noexcept { m_index -= n; return *this; }
+        friend const_iterator operator+( const_iterator it, difference_type n ) noexcept
+        { return it += n; }
+        friend const_iterator operator+( difference_type n, const_iterator it ) noexcept
+        { return it += n; }
+        friend const_iterator operator-( const_iterator it, difference_type n ) noexcept
+        { return it -= n; }
+        friend difference_type operator-( const const_iterator& lhs, const const_iterator& rhs ) noexcept
+        { return static_cast<difference_type>(lhs.m_index) - static_cast<difference_type>(rhs.m_index); }
+        bool operator==( const const_iterator& other ) const noexcept { return m_index == other.m_index; }
+        bool operator!=( const const_iterator& other ) const noexcept { return m_index != other.m_index; }
+        bool operator<( const const_iterator& other ) const noexcept { return m_index < other.m_index; }
+        bool operator>( const const_iterator& other ) const noexcept { return m_index > other.m_index; }
+        bool operator<=( const const_iterator& other ) const noexcept { return m_index <= other.m_index; }
+        bool operator>=( const const_iterator& other ) const noexcept { return m_index >= other.m_index; }
+    private:
+        const MappedLines* m_lines{nullptr};
+        size_type m_index{0};
+    };
+    using iterator = const_iterator;
+
+    // Whether fname is a regular file with contents to map. Empty files, or
+    // ones that only claim to be, are read faster as a stream.
+    static auto can_map( const std::string& fname ) noexcept -> bool;
+
+    // Throws std::runtime_error if fname cannot be opened or mapped
+    explicit MappedLines( const std::string& fname );
+    MappedLines( const MappedLines& ) = delete;
+    MappedLines& operator=( const MappedLines& ) = delete;
+    MappedLines( MappedLines&& other ) noexcept;
+    MappedLines& operator=( MappedLines&& other ) noexcept;
+    ~MappedLines();
+
+    auto size() const noexcept -> size_type { return m_offsets.size() - 1; }
+    auto empty() const noexcept -> bool { return size() == 0; }
+    auto operator[]( size_type n ) const noexcept -> std::string_view
+    {
+        return { m_data + m_offsets[n], m_offsets[n+1] - m_offsets[n] - 1 };
+    }
+
+    auto begin() const noexcept { return const_iterator{this, 0}; }
+    auto end() const noexcept { return const_iterator{this, size()}; }
+    auto cbegin() const noexcept { return begin(); }
+    auto cend() const noexcept { return end(); }
+
+    // The whole mapping, including newlines.
+    auto view() const noexcept -> std::string_view { return { m_data, m_size }; }
+    // Start offset of every line, plus one past-the-end sentinel.
+    auto offsets() const noexcept -> const std::vector<size_type>& { return m_offsets; }
+
+private:
+    void build_index();
+    void unmap() noexcept;
+
+    const char* m_data{nullptr};
+    size_type m_size{0};
+    std::vector<size_type> m_offsets{0};
+};
+
+
+// --- get_lines() over a mapping - the container receives views, not copies
+
+template<typename Container>
+auto get_lines( const MappedLines& mapped ) -> Container
+{
+    auto lines = Container{};
+    for( auto line : mapped ){
+        lines.emplace_back( line );
+    }
+    return lines;
+}
+
+template<typename Container>
+void get_lines( const MappedLines& mapped, Container& container )
+{
+    for( auto line : mapped ){
+        container.emplace_back( line );
+    }
+}
+
+template<typename Container, typename Predicate>
+auto get_lines( const MappedLines& mapped, Predicate predicate ) -> Container
+{
+    auto lines = Container{};
+    for( auto line : mapped ){
+        if( predicate(line) ){
+            lines.emplace_back( line );
+        }
+    }
+    return lines;
+}
+
+template<typename Container, typename Predicate>
+void get_lines( const MappedLines& mapped, Container& container, Predicate predicate )
+{
+    for( auto line : mapped ){
+        if( predicate(line) ){
+            container.emplace_back( line );
+        }
+    }
+}
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_MAPPED_LINES_INCLUDED_HPP_ */
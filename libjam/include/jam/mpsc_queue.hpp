@@ -0,0 +1,96 @@
+#ifndef JAM_MPSC_QUEUE_INCLUDED_HPP_
+#define JAM_MPSC_QUEUE_INCLUDED_HPP_
+
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Lock-free multi-producer queue */
+/* ------------------------------------------------------------------------- */
+// Any number of threads push() without taking a lock - a single
+// compare-and-swap on the list head. One consumer thread takes everything
+// pushed so far in one exchange and gets it oldest first; values pushed by
+// the same thread keep their order.
+// Since the consumer always takes the whole list, nodes are never popped
+// one by one and the usual ABA problem of lock-free stacks does not arise.
+template<typename T>
+class MpscQueue
+{
+    struct Node
+    {
+        T value;
+        Node* next;
+    };
+
+public:
+    MpscQueue() noexcept = default;
+    MpscQueue( const MpscQueue& ) = delete;
+    MpscQueue& operator=( const MpscQueue& ) = delete;
+    ~MpscQueue()
+    {
+        destroy( m_head.load(std::memory_order_acquire) );
+    }
+
+    void push( T value )
+    {
+        auto* node = new Node{ std::move(value), m_head.load(std::memory_order_relaxed) };
+        while( !m_head.compare_exchange_weak( node->next, node,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed ) ){
+        }
+    }
+
+    // Calls function with every value pushed so far, oldest first.
+    // Returns the number of values. Only one thread may consume at a time.
+    template<typename Function>
+    auto consume( Function function ) -> std::size_t
+    {
+        // Newest first as taken - reverse the links
+        Node* oldest = nullptr;
+        for( auto* node = m_head.exchange(nullptr, std::memory_order_acquire); node != nullptr; ){
+            auto* next = node->next;
+            node->next = oldest;
+            oldest = node;
+            node = next;
+        }
+        auto count = std::size_t{0};
+        try{
+            for( ; oldest != nullptr; ++count ){
+                function( std::move(oldest->value) );
+                delete std::exchange( oldest, oldest->next );
+            }
+        }
+        catch( ... ){
+            destroy( oldest );
+            throw;
+        }
+        return count;
+    }
+
+    auto empty() const noexcept -> bool
+    {
+        return m_head.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    static void destroy( Node* node ) noexcept
+    {
+        while( node != nullptr ){
+            delete std::exchange( node, node->next );
+        }
+    }
+
+    std::atomic<Node*> m_head{nullptr};
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_MPSC_QUEUE_INCLUDED_HPP_ */
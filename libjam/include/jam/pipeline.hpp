@@ -0,0 +1,238 @@
+#ifndef JAM_PIPELINE_INCLUDED_HPP_
+#define JAM_PIPELINE_INCLUDED_HPP_
+
+#include "jam/jam.hpp"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Bounded queue */
+/* ------------------------------------------------------------------------- */
+// Blocking FIFO between two threads. push() waits while the queue is full,
+// pop() while it is empty. Once closed, push() refuses new values and pop()
+// hands out what is left, then reports the end.
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue( std::size_t capacity )
+        : m_capacity{ capacity != 0 ? capacity : 1 }
+        { }
+
+    auto push( T value ) -> bool
+    {
+        auto lock = std::unique_lock<std::mutex>{m_mutex};
+        m_not_full.wait( lock, [this]{ return m_closed || m_values.size() < m_capacity; } );
+        if( m_closed ){
+            return false;
+        }
+        m_values.push_back(std::move(value));
+        lock.unlock();
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    auto pop( T& value ) -> bool
+    {
+        auto lock = std::unique_lock<std::mutex>{m_mutex};
+        m_not_empty.wait( lock, [this]{ return m_closed || !m_values.empty(); } );
+        if( m_values.empty() ){
+            return false;
+        }
+        value = std::move(m_values.front());
+        m_values.pop_front();
+        lock.unlock();
+        m_not_full.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            auto lock = std::lock_guard<std::mutex>{m_mutex};
+            m_closed = true;
+        }
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+
+private:
+    std::mutex m_mutex{};
+    std::condition_variable m_not_full{};
+    std::condition_variable m_not_empty{};
+    std::deque<T> m_values{};
+    std::size_t m_capacity;
+    bool m_closed{false};
+};
+/* ------------------------------------------------------------------------- */
+
+
+/* Streaming pipeline */
+/* ------------------------------------------------------------------------- */
+// Throughput of a single stage. Updated by the stage's own thread while the
+// pipeline runs, so the counters can be polled from outside.
+struct StageStats
+{
+    explicit StageStats( std::string stage_name ) : name{std::move(stage_name)} { }
+
+    // Lines per second and bytes per second while the stage was busy, i.e.
+    // not counting the time spent waiting on its queues
+    auto lines_per_second() const noexcept -> double;
+    auto bytes_per_second() const noexcept -> double;
+
+    std::string name;
+    std::atomic<std::uint64_t> lines_in{0};
+    std::atomic<std::uint64_t> lines_out{0};
+    std::atomic<std::uint64_t> bytes_out{0};
+    std::atomic<std::uint64_t> busy_nanoseconds{0};
+};
+
+auto operator<<( std::ostream& os, const StageStats& stats ) -> std::ostream&;
+
+// Reader -> transform/filter stages -> writer, every stage on a thread of its
+// own and connected to the next one by a bounded queue of line batches, so
+// reading, processing and writing overlap and memory use stays bounded.
+//
+//     auto pipeline = jam::Pipeline{};
+//     pipeline.filter( is_comment, "comments" )
+//             .transform( to_upper, "upper" );
+//     pipeline.run( std::cin, std::cout );
+//
+// The reader stage is jam::get_lines(), with the optional predicate applied
+// as the lines are read. Lines are written followed by '\n'.
+class Pipeline
+{
+public:
+    using Batch = std::vector<std::string>;
+
+    static constexpr std::size_t default_queue_capacity{8};
+    static constexpr std::size_t default_batch_size{4096};
+
+    explicit Pipeline( std::size_t queue_capacity = default_queue_capacity,
+                       std::size_t batch_size = default_batch_size );
+
+    // Keeps the lines for which predicate(line) holds
+    template<typename Predicate>
+    auto filter( Predicate predicate, std::string name = "filter" ) -> Pipeline&
+    {
+        return add_stage( std::move(name), [predicate]( Batch& batch ) mutable {
+            batch.erase( std::remove_if( batch.begin(), batch.end(),
+                             [&predicate]( const std::string& line ){ return !predicate(line); } ),
+                         batch.end() );
+        });
+    }
+
+    // Replaces every line with function(line)
+    template<typename Function>
+    auto transform( Function function, std::string name = "transform" ) -> Pipeline&
+    {
+        return add_stage( std::move(name), [function]( Batch& batch ) mutable {
+            for( auto& line : batch ){
+                line = function(line);
+            }
+        });
+    }
+
+    // Keeps the lines for which function(line) holds, function may rewrite
+    // the line in place. Saves the copy a transform() would make of lines a
+    // filter() throws away next.
+    template<typename Function>
+    auto filter_transform( Function function, std::string name = "filter_transform" ) -> Pipeline&
+    {
+        return add_stage( std::move(name), [function]( Batch& batch ) mutable {
+            // In order, one line at a time - function may count the lines
+            auto kept = batch.begin();
+            for( auto& line : batch ){
+                if( !function(line) ){
+                    continue;
+                }
+                if( &*kept != &line ){
+                    *kept = std::move(line);
+                }
+                ++kept;
+            }
+            batch.erase( kept, batch.end() );
+        });
+    }
+
+    // Runs every stage to completion. The first exception thrown by any of
+    // the stages is rethrown once all of them have stopped.
+    template<typename Predicate>
+    void run( std::istream& is, std::ostream& os, Predicate predicate )
+    {
+        run_stages( [&is, &predicate]( BatchSink& sink ){
+            get_lines( is, sink, [&]( const std::string& line ){
+                sink.count_line();
+                return predicate(line);
+            });
+        }, os );
+    }
+
+    void run( std::istream& is, std::ostream& os )
+    {
+        run( is, os, []( const std::string& ){ return true; } );
+    }
+
+    // Reader first, writer last - valid once run() was called
+    auto stats() const noexcept -> const std::vector<std::unique_ptr<StageStats>>& { return m_stats; }
+    void report( std::ostream& os ) const;
+
+private:
+    using Queue = BoundedQueue<Batch>;
+
+    // Collects the lines handed over by get_lines() into batches for the
+    // first queue
+    class BatchSink
+    {
+    public:
+        BatchSink( Queue& queue, StageStats& stats, std::size_t batch_size );
+        void count_line() noexcept { m_stats.lines_in.fetch_add(1, std::memory_order_relaxed); }
+        void emplace_back( std::string&& line );
+        void flush();
+        // Time spent blocked on a full queue
+        auto waiting_nanoseconds() const noexcept -> std::uint64_t { return m_waiting; }
+    private:
+        Queue& m_queue;
+        StageStats& m_stats;
+        std::size_t m_batch_size;
+        Batch m_batch{};
+        std::uint64_t m_waiting{0};
+    };
+
+    struct Stage
+    {
+        std::string name;
+        std::function<void(Batch&)> process;
+    };
+
+    auto add_stage( std::string name, std::function<void(Batch&)> process ) -> Pipeline&;
+    void run_stages( std::function<void(BatchSink&)> read, std::ostream& os );
+
+    std::size_t m_queue_capacity;
+    std::size_t m_batch_size;
+    std::vector<Stage> m_stages{};
+    std::vector<std::unique_ptr<StageStats>> m_stats{};
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_PIPELINE_INCLUDED_HPP_ */
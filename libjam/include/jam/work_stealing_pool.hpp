@@ -0,0 +1,85 @@
+#ifndef JAM_WORK_STEALING_POOL_INCLUDED_HPP_
+#define JAM_WORK_STEALING_POOL_INCLUDED_HPP_
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace jam
+{
+
+
+/* Work-stealing thread pool */
+/* ------------------------------------------------------------------------- */
+// A fixed number of worker threads, each with a deque of tasks of its own.
+// Tasks submitted from a worker go to the back of that worker's deque and
+// the worker takes them from the back again, so a recursive walk stays depth
+// first and the deques stay short. A worker that runs dry steals from the
+// front of the others' deques, where the oldest - usually the largest - tasks
+// wait.
+// Tasks may submit further tasks; wait() returns once all of them are done.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // 0 threads means one per hardware thread
+    explicit WorkStealingPool( unsigned threads = 0 );
+    WorkStealingPool( const WorkStealingPool& ) = delete;
+    WorkStealingPool& operator=( const WorkStealingPool& ) = delete;
+    // Runs the tasks still queued, then stops the workers
+    ~WorkStealingPool();
+
+    void submit( Task task );
+
+    // Blocks until every task submitted so far, and every task those
+    // submitted, has run. Rethrows the first exception a task threw - the
+    // remaining tasks still run.
+    void wait();
+
+    auto size() const noexcept -> unsigned { return static_cast<unsigned>(m_workers.size()); }
+    // Tasks a worker took from another worker's deque
+    auto steals() const noexcept -> std::uint64_t { return m_steals.load(); }
+
+private:
+    struct Worker
+    {
+        std::mutex mutex{};
+        std::deque<Task> tasks{};
+        std::thread thread{};
+    };
+
+    void work( std::size_t index );
+    auto pop( std::size_t index, Task& task ) -> bool;
+    auto steal( std::size_t index, Task& task ) -> bool;
+    void run( Task& task );
+
+    std::vector<std::unique_ptr<Worker>> m_workers{};
+    // Tasks in the deques, and tasks not finished yet
+    std::atomic<std::size_t> m_queued{0};
+    std::atomic<std::size_t> m_pending{0};
+    std::atomic<std::size_t> m_next_worker{0};
+    std::atomic<std::uint64_t> m_steals{0};
+
+    std::mutex m_mutex{};
+    std::condition_variable m_work_available{};
+    std::condition_variable m_all_done{};
+    bool m_stop{false};
+    std::exception_ptr m_error{};
+};
+/* ------------------------------------------------------------------------- */
+
+
+} // namespace
+
+
+#endif /* JAM_WORK_STEALING_POOL_INCLUDED_HPP_ */
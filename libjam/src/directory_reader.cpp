@@ -0,0 +1,215 @@
+#include "directory_reader.hpp"
+#include <stdexcept>
+#include <utility>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+
+namespace jam
+{
+
+
+namespace
+{
+#if defined(__linux__)
+// Layout of the records getdents64(2) fills the buffer with
+struct LinuxDirent64
+{
+    std::uint64_t d_ino;
+    std::int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+#endif
+
+#if defined(DT_UNKNOWN)
+auto to_entry_type( unsigned char d_type ) noexcept -> EntryType
+{
+    switch( d_type ){
+    case DT_REG: return EntryType::regular;
+    case DT_DIR: return EntryType::directory;
+    case DT_LNK: return EntryType::symlink;
+    case DT_UNKNOWN: return EntryType::unknown;
+    default: return EntryType::other;
+    }
+}
+#endif
+
+auto to_entry_type( mode_t mode ) noexcept -> EntryType
+{
+    switch( mode & S_IFMT ){
+    case S_IFREG: return EntryType::regular;
+    case S_IFDIR: return EntryType::directory;
+    case S_IFLNK: return EntryType::symlink;
+    default: return EntryType::other;
+    }
+}
+
+[[noreturn]] void throw_error( const char* what, std::string_view name )
+{
+    throw std::runtime_error( std::string{what} + " " + std::string{name} + ": " + std::strerror(errno) );
+}
+} // namespace
+
+
+auto DirectoryEntry::type() -> EntryType
+{
+    if( m_type == EntryType::unknown ){
+        m_type = to_entry_type( status().st_mode );
+    }
+    return m_type;
+}
+
+auto DirectoryEntry::status() -> const struct stat&
+{
+    if( !m_has_status ){
+        // The name is followed by the '\0' of the getdents64 record
+        if( ::fstatat(m_dir_fd, m_name.data(), &m_status, AT_SYMLINK_NOFOLLOW) == -1 ){
+            throw_error( "Failed to stat", m_name );
+        }
+        m_has_status = true;
+    }
+    return m_status;
+}
+
+
+DirectoryReader::DirectoryReader( int dir_fd, const char* path, std::size_t block_size )
+    : m_fd{ ::openat(dir_fd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC) }
+    , m_block(std::max<std::size_t>(block_size, 1024))
+{
+    if( m_fd == -1 ){
+        throw_error( "Failed to open the directory", path );
+    }
+#if !defined(__linux__)
+    // The stream owns the descriptor from now on
+    m_dir = ::fdopendir(m_fd);
+    if( m_dir == nullptr ){
+        const auto error = errno;
+        ::close(m_fd);
+        errno = error;
+        throw_error( "Failed to open the directory", path );
+    }
+#endif
+}
+
+DirectoryReader::DirectoryReader( const std::string& path, std::size_t block_size )
+    : DirectoryReader{ AT_FDCWD, path.c_str(), block_size }
+{
+}
+
+DirectoryReader::DirectoryReader( DirectoryReader&& other ) noexcept
+    : m_fd{std::exchange(other.m_fd, -1)}
+    , m_dir{std::exchange(other.m_dir, nullptr)}
+    , m_block{std::move(other.m_block)}
+    , m_offset{other.m_offset}
+    , m_size{other.m_size}
+{
+}
+
+DirectoryReader& DirectoryReader::operator=( DirectoryReader&& other ) noexcept
+{
+    if( this != &other ){
+        close();
+        m_fd = std::exchange(other.m_fd, -1);
+        m_dir = std::exchange(other.m_dir, nullptr);
+        m_block = std::move(other.m_block);
+        m_offset = other.m_offset;
+        m_size = other.m_size;
+    }
+    return *this;
+}
+
+DirectoryReader::~DirectoryReader()
+{
+    close();
+}
+
+void DirectoryReader::close() noexcept
+{
+    if( m_dir != nullptr ){
+        ::closedir(m_dir);
+        m_dir = nullptr;
+        m_fd = -1;
+    }
+    if( m_fd != -1 ){
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+#if defined(__linux__)
+auto DirectoryReader::next( DirectoryEntry& entry ) -> bool
+{
+    for( ;; ){
+        if( m_offset == m_size ){
+            const auto got = ::syscall( SYS_getdents64, m_fd, m_block.data(), m_block.size() );
+            if( got == -1 ){
+                throw std::runtime_error( std::string{"Failed to read a directory: "} + std::strerror(errno) );
+            }
+            if( got == 0 ){
+                return false;
+            }
+            m_offset = 0;
+            m_size = static_cast<std::size_t>(got);
+        }
+
+        const auto* record = reinterpret_cast<const LinuxDirent64*>( m_block.data() + m_offset );
+        m_offset += record->d_reclen;
+
+        const auto name = std::string_view{ record->d_name };
+        if( name == "." || name == ".." ){
+            continue;
+        }
+        entry.m_dir_fd = m_fd;
+        entry.m_name = name;
+        entry.m_inode = static_cast<ino_t>(record->d_ino);
+        entry.m_type = to_entry_type(record->d_type);
+        entry.m_has_status = false;
+        return true;
+    }
+}
+#else
+// Without getdents64 readdir(3) does the buffering, the record it returns
+// stays valid up to the next call
+auto DirectoryReader::next( DirectoryEntry& entry ) -> bool
+{
+    for( ;; ){
+        errno = 0;
+        const auto* record = ::readdir(m_dir);
+        if( record == nullptr ){
+            if( errno != 0 ){
+                throw std::runtime_error( std::string{"Failed to read a directory: "} + std::strerror(errno) );
+            }
+            return false;
+        }
+
+        const auto name = std::string_view{ record->d_name };
+        if( name == "." || name == ".." ){
+            continue;
+        }
+        entry.m_dir_fd = m_fd;
+        entry.m_name = name;
+        entry.m_inode = static_cast<ino_t>(record->d_ino);
+#if defined(DT_UNKNOWN)
+        entry.m_type = to_entry_type(record->d_type);
+#else
+        entry.m_type = EntryType::unknown;
+#endif
+        entry.m_has_status = false;
+        return true;
+    }
+}
+#endif
+
+
+} // namespace
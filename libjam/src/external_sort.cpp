@@ -0,0 +1,79 @@
+#include "external_sort.hpp"
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+#include <utility>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace jam
+{
+
+
+TemporaryFile::TemporaryFile( const std::string& directory )
+{
+    auto dir = directory;
+    if( dir.empty() ){
+        const auto* tmpdir = std::getenv("TMPDIR");
+        dir = tmpdir != nullptr && *tmpdir != '\0' ? tmpdir : "/tmp";
+    }
+    auto name = dir + "/jam-XXXXXX";
+    auto buffer = std::vector<char>(name.cbegin(), name.cend());
+    buffer.push_back('\0');
+    const auto fd = ::mkstemp( buffer.data() );
+    if( fd == -1 ){
+        throw std::runtime_error( "Failed to create a temporary file in " + dir );
+    }
+    ::close(fd);
+    m_path = buffer.data();
+}
+
+TemporaryFile::TemporaryFile( TemporaryFile&& other ) noexcept
+    : m_path{std::exchange(other.m_path, {})}
+{
+}
+
+TemporaryFile& TemporaryFile::operator=( TemporaryFile&& other ) noexcept
+{
+    if( this != &other ){
+        if( !m_path.empty() ){
+            std::remove( m_path.c_str() );
+        }
+        m_path = std::exchange(other.m_path, {});
+    }
+    return *this;
+}
+
+TemporaryFile::~TemporaryFile()
+{
+    if( !m_path.empty() ){
+        std::remove( m_path.c_str() );
+    }
+}
+
+void TemporaryFile::keep_as( const std::string& fname )
+{
+    // mkstemp() creates the file 0600 - a replaced file keeps its own mode
+    struct stat target{};
+    if( ::stat(fname.c_str(), &target) == 0 ){
+        ::chmod( m_path.c_str(), target.st_mode & 07777 );
+    }
+    if( std::rename(m_path.c_str(), fname.c_str()) != 0 ){
+        throw std::runtime_error( "Failed to rename " + m_path + " to " + fname );
+    }
+    m_path.clear();
+}
+
+auto same_file( const std::string& lhs, const std::string& rhs ) -> bool
+{
+    struct stat lhs_stat{};
+    struct stat rhs_stat{};
+    return ::stat(lhs.c_str(), &lhs_stat) == 0 && ::stat(rhs.c_str(), &rhs_stat) == 0
+        && lhs_stat.st_dev == rhs_stat.st_dev && lhs_stat.st_ino == rhs_stat.st_ino;
+}
+
+
+} // namespace
@@ -0,0 +1,258 @@
+#include "file_copy.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+
+namespace jam
+{
+
+
+namespace
+{
+#if defined(__linux__)
+// Largest amount asked for in one call
+constexpr std::size_t chunk_size{std::size_t{1} << 30};
+constexpr std::size_t pipe_size{std::size_t{1} << 20};
+#endif
+constexpr std::size_t buffer_size{std::size_t{1} << 20};
+
+[[noreturn]] void throw_error( const char* call )
+{
+    throw std::runtime_error( std::string{"Failed to copy ("} + call + "): " + std::strerror(errno) );
+}
+
+void write_all( int fd, const char* data, std::size_t size )
+{
+    while( size != 0 ){
+        const auto written = ::write(fd, data, size);
+        if( written == -1 ){
+            if( errno == EINTR )
+                continue;
+            throw_error("write");
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+#if defined(__linux__)
+// The kernel does not do this for the given pair of descriptors
+auto refused( int error ) noexcept -> bool
+{
+    return error == EINVAL || error == ENOSYS || error == EXDEV || error == EOPNOTSUPP
+        || error == EBADF || error == ESPIPE;
+}
+
+auto file_type( int fd ) noexcept -> mode_t
+{
+    struct stat st{};
+    return ::fstat(fd, &st) == 0 ? (st.st_mode & S_IFMT) : 0;
+}
+
+class Pipe
+{
+public:
+    Pipe()
+    {
+        if( ::pipe2(m_fds, O_CLOEXEC) == -1 )
+            throw_error("pipe2");
+        // Larger pipes mean fewer splice calls; keep the default if not allowed
+        ::fcntl( m_fds[1], F_SETPIPE_SZ, static_cast<int>(pipe_size) );
+    }
+    Pipe( const Pipe& ) = delete;
+    Pipe& operator=( const Pipe& ) = delete;
+    ~Pipe()
+    {
+        ::close(m_fds[0]);
+        ::close(m_fds[1]);
+    }
+    auto read_end() const noexcept -> int { return m_fds[0]; }
+    auto write_end() const noexcept -> int { return m_fds[1]; }
+private:
+    int m_fds[2]{-1, -1};
+};
+
+// Each of these returns true once the input is exhausted, false if the
+// method was refused. Bytes copied before a refusal are counted.
+
+auto copy_with_copy_file_range( int in_fd, int out_fd, std::size_t& copied ) -> bool
+{
+    // Special files may claim to be empty, and the output must be a file
+    if( file_type(in_fd) != S_IFREG || file_type(out_fd) != S_IFREG )
+        return false;
+    for( ;; ){
+        const auto n = ::copy_file_range(in_fd, nullptr, out_fd, nullptr, chunk_size, 0);
+        if( n > 0 ){
+            copied += static_cast<std::size_t>(n);
+        }
+        else if( n == 0 ){
+            return true;
+        }
+        else if( errno != EINTR ){
+            if( refused(errno) )
+                return false;
+            throw_error("copy_file_range");
+        }
+    }
+}
+
+auto splice_directly( int in_fd, int out_fd, std::size_t& copied ) -> bool
+{
+    for( ;; ){
+        const auto n = ::splice(in_fd, nullptr, out_fd, nullptr, chunk_size, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if( n > 0 ){
+            copied += static_cast<std::size_t>(n);
+        }
+        else if( n == 0 ){
+            return true;
+        }
+        else if( errno != EINTR ){
+            if( refused(errno) )
+                return false;
+            throw_error("splice");
+        }
+    }
+}
+
+auto splice_through_pipe( int in_fd, int out_fd, std::size_t& copied ) -> bool
+{
+    auto pipe = Pipe{};
+    for( ;; ){
+        const auto in = ::splice(in_fd, nullptr, pipe.write_end(), nullptr, pipe_size, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if( in == 0 ){
+            return true;
+        }
+        if( in == -1 ){
+            if( errno == EINTR )
+                continue;
+            if( refused(errno) )
+                return false;
+            throw_error("splice");
+        }
+        for( auto pending = static_cast<std::size_t>(in); pending != 0; ){
+            const auto out = ::splice(pipe.read_end(), nullptr, out_fd, nullptr, pending, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if( out > 0 ){
+                pending -= static_cast<std::size_t>(out);
+                copied += static_cast<std::size_t>(out);
+                continue;
+            }
+            if( out == -1 && errno == EINTR )
+                continue;
+            if( out == -1 && !refused(errno) )
+                throw_error("splice");
+            // The output does not take splices - hand over what is stuck in
+            // the pipe the ordinary way before giving up on this method
+            auto buffer = std::vector<char>(pending);
+            auto filled = std::size_t{0};
+            while( filled != pending ){
+                const auto n = ::read(pipe.read_end(), buffer.data() + filled, pending - filled);
+                if( n <= 0 ){
+                    if( n == -1 && errno == EINTR )
+                        continue;
+                    throw_error("read");
+                }
+                filled += static_cast<std::size_t>(n);
+            }
+            write_all(out_fd, buffer.data(), buffer.size());
+            copied += pending;
+            return false;
+        }
+    }
+}
+
+auto copy_with_splice( int in_fd, int out_fd, std::size_t& copied ) -> bool
+{
+    if( file_type(in_fd) == S_IFIFO || file_type(out_fd) == S_IFIFO )
+        return splice_directly(in_fd, out_fd, copied);
+    return splice_through_pipe(in_fd, out_fd, copied);
+}
+
+auto copy_with_sendfile( int in_fd, int out_fd, std::size_t& copied ) -> bool
+{
+    for( ;; ){
+        const auto n = ::sendfile(out_fd, in_fd, nullptr, chunk_size);
+        if( n > 0 ){
+            copied += static_cast<std::size_t>(n);
+        }
+        else if( n == 0 ){
+            return true;
+        }
+        else if( errno != EINTR ){
+            if( refused(errno) )
+                return false;
+            throw_error("sendfile");
+        }
+    }
+}
+#else
+// copy_file_range, splice and sendfile as copy_fd() uses them are Linux
+// system calls, elsewhere they are always refused
+auto copy_with_copy_file_range( int, int, std::size_t& ) noexcept -> bool { return false; }
+auto copy_with_splice( int, int, std::size_t& ) noexcept -> bool { return false; }
+auto copy_with_sendfile( int, int, std::size_t& ) noexcept -> bool { return false; }
+#endif
+
+void copy_with_read_write( int in_fd, int out_fd, std::size_t& copied )
+{
+    auto buffer = std::vector<char>(buffer_size);
+    for( ;; ){
+        const auto n = ::read(in_fd, buffer.data(), buffer.size());
+        if( n == 0 )
+            return;
+        if( n == -1 ){
+            if( errno == EINTR )
+                continue;
+            throw_error("read");
+        }
+        write_all(out_fd, buffer.data(), static_cast<std::size_t>(n));
+        copied += static_cast<std::size_t>(n);
+    }
+}
+} // namespace
+
+
+auto to_string( CopyMethod method ) noexcept -> const char*
+{
+    switch( method ){
+        case CopyMethod::copy_file_range: return "copy_file_range";
+        case CopyMethod::splice: return "splice";
+        case CopyMethod::sendfile: return "sendfile";
+        case CopyMethod::read_write: return "read/write";
+    }
+    return "unknown";
+}
+
+auto copy_fd( int in_fd, int out_fd, CopyMethod first ) -> std::size_t
+{
+    auto copied = std::size_t{0};
+    switch( first ){
+        case CopyMethod::copy_file_range:
+            if( copy_with_copy_file_range(in_fd, out_fd, copied) )
+                return copied;
+            [[fallthrough]];
+        case CopyMethod::splice:
+            if( copy_with_splice(in_fd, out_fd, copied) )
+                return copied;
+            [[fallthrough]];
+        case CopyMethod::sendfile:
+            if( copy_with_sendfile(in_fd, out_fd, copied) )
+                return copied;
+            [[fallthrough]];
+        case CopyMethod::read_write:
+            copy_with_read_write(in_fd, out_fd, copied);
+    }
+    return copied;
+}
+
+
+} // namespace
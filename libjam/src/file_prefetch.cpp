@@ -0,0 +1,103 @@
+#include "file_prefetch.hpp"
+#include <utility>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace jam
+{
+
+
+namespace
+{
+auto open_file( const std::string& name ) -> PrefetchedFile
+{
+    const auto fd = ::open( name.c_str(), O_RDONLY | O_CLOEXEC );
+    return PrefetchedFile{ name, fd, fd == -1 ? errno : 0 };
+}
+} // namespace
+
+
+PrefetchedFile::PrefetchedFile( PrefetchedFile&& other ) noexcept
+    : m_name{std::move(other.m_name)}
+    , m_fd{std::exchange(other.m_fd, -1)}
+    , m_error{other.m_error}
+{
+}
+
+PrefetchedFile& PrefetchedFile::operator=( PrefetchedFile&& other ) noexcept
+{
+    if( this != &other ){
+        if( m_fd != -1 ){
+            ::close(m_fd);
+        }
+        m_name = std::move(other.m_name);
+        m_fd = std::exchange(other.m_fd, -1);
+        m_error = other.m_error;
+    }
+    return *this;
+}
+
+PrefetchedFile::~PrefetchedFile()
+{
+    if( m_fd != -1 ){
+        ::close(m_fd);
+    }
+}
+
+
+FilePrefetcher::FilePrefetcher( std::vector<std::string> files, std::size_t depth, std::size_t window )
+    : m_files{std::move(files)}
+    , m_window{window}
+    , m_queue{depth}
+{
+    if( depth != 0 ){
+        m_thread = std::thread{ [this]{ prefetch(); } };
+    }
+}
+
+FilePrefetcher::~FilePrefetcher()
+{
+    m_queue.close();
+    if( m_thread.joinable() ){
+        m_thread.join();
+    }
+}
+
+void FilePrefetcher::prefetch()
+{
+    for( const auto& name : m_files ){
+        auto file = open_file(name);
+        if( file.fd() != -1 ){
+            // Only a hint - a failure costs the read-ahead, nothing else. Not
+            // every system has posix_fadvise, the file is just opened there.
+#if defined(POSIX_FADV_WILLNEED)
+            ::posix_fadvise( file.fd(), 0, static_cast<off_t>(m_window), POSIX_FADV_SEQUENTIAL );
+            ::posix_fadvise( file.fd(), 0, static_cast<off_t>(m_window), POSIX_FADV_WILLNEED );
+#else
+            static_cast<void>(m_window);
+#endif
+        }
+        if( !m_queue.push(std::move(file)) ){
+            return;
+        }
+    }
+    m_queue.close();
+}
+
+auto FilePrefetcher::next( PrefetchedFile& file ) -> bool
+{
+    if( !m_thread.joinable() ){
+        if( m_next == m_files.size() ){
+            return false;
+        }
+        file = open_file( m_files[m_next++] );
+        return true;
+    }
+    return m_queue.pop(file);
+}
+
+
+} // namespace
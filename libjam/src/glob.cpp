@@ -0,0 +1,224 @@
+#include "glob.hpp"
+#include <cstring>
+
+
+namespace jam
+{
+
+
+namespace
+{
+auto to_lower( unsigned char ch ) noexcept -> unsigned char
+{
+    return ch >= 'A' && ch <= 'Z' ? static_cast<unsigned char>(ch - 'A' + 'a') : ch;
+}
+
+auto to_upper( unsigned char ch ) noexcept -> unsigned char
+{
+    return ch >= 'a' && ch <= 'z' ? static_cast<unsigned char>(ch - 'a' + 'A') : ch;
+}
+
+// Parses the set starting after the '[' at pattern[pos] into its characters
+// and whether it is negated. Returns the position after its ']', or 0 if the
+// set is not terminated - the '[' is an ordinary character then, same as
+// with fnmatch(3).
+auto parse_set( std::string_view pattern, std::size_t pos, std::bitset<256>& set, bool& negate ) -> std::size_t
+{
+    negate = false;
+    if( pos < pattern.size() && (pattern[pos] == '!' || pattern[pos] == '^') ){
+        negate = true;
+        ++pos;
+    }
+    for( auto first = true; pos < pattern.size(); first = false ){
+        auto ch = static_cast<unsigned char>(pattern[pos]);
+        if( ch == ']' && !first ){
+            return pos + 1;
+        }
+        if( ch == '\\' && pos + 1 < pattern.size() ){
+            ch = static_cast<unsigned char>(pattern[++pos]);
+        }
+        ++pos;
+        auto last = ch;
+        if( pos + 1 < pattern.size() && pattern[pos] == '-' && pattern[pos + 1] != ']' ){
+            pos += 1;
+            if( pattern[pos] == '\\' && pos + 1 < pattern.size() ){
+                ++pos;
+            }
+            last = static_cast<unsigned char>(pattern[pos++]);
+        }
+        for( unsigned c = ch; c <= last; ++c ){
+            set.set(c);
+        }
+    }
+    return 0;
+}
+} // namespace
+
+
+Glob::Glob( std::string_view pattern, bool ignore_case )
+    : m_pattern{pattern}
+    , m_ignore_case{ignore_case}
+{
+    m_pieces.emplace_back();
+    const auto add = [this]( Token token ){
+        auto& piece = m_pieces.back();
+        piece.tokens.push_back(token);
+        if( token.kind == Token::Kind::character ){
+            piece.literal += static_cast<char>(token.character);
+        }
+        else{
+            piece.is_literal = false;
+        }
+    };
+
+    for( std::size_t pos = 0; pos < pattern.size(); ){
+        const auto ch = static_cast<unsigned char>(pattern[pos]);
+        if( ch == '*' ){
+            while( pos < pattern.size() && pattern[pos] == '*' ){
+                ++pos;
+            }
+            m_pieces.emplace_back();
+            continue;
+        }
+        if( ch == '?' ){
+            add( Token{ Token::Kind::any, 0, 0 } );
+            ++pos;
+            continue;
+        }
+        if( ch == '[' ){
+            auto set = std::bitset<256>{};
+            auto negate = false;
+            if( const auto end = parse_set(pattern, pos + 1, set, negate); end != 0 ){
+                if( m_ignore_case ){
+                    for( unsigned c = 0; c != 256; ++c ){
+                        if( set.test(c) ){
+                            set.set( to_lower(static_cast<unsigned char>(c)) );
+                            set.set( to_upper(static_cast<unsigned char>(c)) );
+                        }
+                    }
+                }
+                if( negate ){
+                    set.flip();
+                }
+                m_sets.push_back(set);
+                add( Token{ Token::Kind::set, 0, static_cast<std::uint16_t>(m_sets.size() - 1) } );
+                pos = end;
+                continue;
+            }
+        }
+        auto literal = ch;
+        if( ch == '\\' && pos + 1 < pattern.size() ){
+            literal = static_cast<unsigned char>(pattern[++pos]);
+        }
+        add( Token{ Token::Kind::character, fold(literal), 0 } );
+        ++pos;
+    }
+
+    m_leading_star = m_pieces.size() > 1 && m_pieces.front().tokens.empty();
+    m_trailing_star = m_pieces.size() > 1 && m_pieces.back().tokens.empty();
+    const auto all_literal = [this]{
+        for( const auto& piece : m_pieces ){
+            if( !piece.is_literal )
+                return false;
+        }
+        return true;
+    }();
+    if( all_literal ){
+        if( m_pieces.size() == 1 ){
+            m_shape = Shape::exact;
+        }
+        else if( m_pieces.size() == 2 && !m_leading_star && m_trailing_star ){
+            m_shape = Shape::prefix;
+        }
+        else if( m_pieces.size() == 2 && m_leading_star && !m_trailing_star ){
+            m_shape = Shape::suffix;
+        }
+        else if( m_pieces.size() == 3 && m_leading_star && m_trailing_star ){
+            m_shape = Shape::contains;
+        }
+    }
+}
+
+auto Glob::fold( unsigned char ch ) const noexcept -> unsigned char
+{
+    return m_ignore_case ? to_lower(ch) : ch;
+}
+
+auto Glob::matches_at( const Piece& piece, std::string_view name, std::size_t pos ) const noexcept -> bool
+{
+    if( piece.is_literal && !m_ignore_case ){
+        return std::memcmp( name.data() + pos, piece.literal.data(), piece.literal.size() ) == 0;
+    }
+    for( const auto& token : piece.tokens ){
+        const auto ch = static_cast<unsigned char>(name[pos++]);
+        switch( token.kind ){
+        case Token::Kind::character:
+            if( fold(ch) != token.character )
+                return false;
+            break;
+        case Token::Kind::any:
+            break;
+        case Token::Kind::set:
+            if( !m_sets[token.set].test(ch) )
+                return false;
+            break;
+        }
+    }
+    return true;
+}
+
+auto Glob::find( const Piece& piece, std::string_view name,
+                 std::size_t first, std::size_t last ) const noexcept -> std::size_t
+{
+    const auto size = piece.tokens.size();
+    if( piece.is_literal && !m_ignore_case ){
+        return name.substr(0, last).find( piece.literal, first );
+    }
+    for( auto pos = first; pos + size <= last; ++pos ){
+        if( matches_at(piece, name, pos) )
+            return pos;
+    }
+    return std::string_view::npos;
+}
+
+auto Glob::operator()( std::string_view name ) const noexcept -> bool
+{
+    const auto& front = m_pieces.front();
+    const auto& back = m_pieces.back();
+    switch( m_shape ){
+    case Shape::exact:
+        return name.size() == front.tokens.size() && matches_at(front, name, 0);
+    case Shape::prefix:
+        return name.size() >= front.tokens.size() && matches_at(front, name, 0);
+    case Shape::suffix:
+        return name.size() >= back.tokens.size()
+            && matches_at(back, name, name.size() - back.tokens.size());
+    case Shape::contains:
+        return find(m_pieces[1], name, 0, name.size()) != std::string_view::npos;
+    case Shape::general:
+        break;
+    }
+
+    if( m_pieces.size() == 1 ){
+        return name.size() == front.tokens.size() && matches_at(front, name, 0);
+    }
+    // Both ends are anchored, the pieces in between can float - the leftmost
+    // place for each leaves the most room for the rest
+    if( name.size() < front.tokens.size() + back.tokens.size()
+        || !matches_at(front, name, 0)
+        || !matches_at(back, name, name.size() - back.tokens.size()) ){
+        return false;
+    }
+    auto pos = front.tokens.size();
+    const auto last = name.size() - back.tokens.size();
+    for( std::size_t i = 1; i + 1 < m_pieces.size(); ++i ){
+        const auto found = find(m_pieces[i], name, pos, last);
+        if( found == std::string_view::npos )
+            return false;
+        pos = found + m_pieces[i].tokens.size();
+    }
+    return true;
+}
+
+
+} // namespace
@@ -0,0 +1,116 @@
+#include "key_field.hpp"
+#include <charconv>
+#include <stdexcept>
+#include <algorithm>
+
+
+namespace jam
+{
+
+
+namespace
+{
+auto is_blank( char ch ) noexcept -> bool
+{
+    return ch == ' ' || ch == '\t';
+}
+
+struct Position
+{
+    std::size_t field;
+    std::size_t character;
+};
+
+// F[.C], where a missing C is returned as 0
+auto parse_position( std::string_view text, std::string_view definition ) -> Position
+{
+    const auto invalid = [&]{
+        return std::invalid_argument( "Invalid key definition " + std::string{definition} );
+    };
+    auto position = Position{0, 0};
+    const auto* first = text.data();
+    const auto* last = text.data() + text.size();
+    auto result = std::from_chars(first, last, position.field);
+    if( result.ec != std::errc{} || position.field == 0 ){
+        throw invalid();
+    }
+    if( result.ptr != last && *result.ptr == '.' ){
+        result = std::from_chars(result.ptr + 1, last, position.character);
+        if( result.ec != std::errc{} ){
+            throw invalid();
+        }
+    }
+    if( result.ptr != last ){
+        throw invalid();
+    }
+    return position;
+}
+} // namespace
+
+
+KeyField::KeyField( std::string_view definition, std::optional<char> separator )
+    : m_separator{separator}
+{
+    const auto comma = definition.find(',');
+    const auto begin = parse_position( definition.substr(0, comma), definition );
+    if( begin.character == 0 && definition.substr(0, comma).find('.') != std::string_view::npos ){
+        throw std::invalid_argument( "Invalid key definition " + std::string{definition} );
+    }
+    m_begin_field = begin.field - 1;
+    m_begin_char = begin.character != 0 ? begin.character - 1 : 0;
+    if( comma != std::string_view::npos ){
+        const auto end = parse_position( definition.substr(comma + 1), definition );
+        m_end_field = end.field - 1;
+        m_end_char = end.character;
+    }
+}
+
+auto KeyField::operator()( std::string_view line ) const noexcept -> std::string_view
+{
+    // Like sort(1), a character offset past the end of its field runs on
+    // into the rest of the line
+    const auto begin = std::min( field_begin(line, m_begin_field) + m_begin_char, line.size() );
+    auto end = line.size();
+    if( m_end_field ){
+        const auto last_field = field_begin(line, *m_end_field);
+        end = m_end_char != 0 ? std::min( last_field + m_end_char, line.size() )
+                              : field_end(line, last_field);
+    }
+    if( end <= begin ){
+        return line.substr(begin, 0);
+    }
+    return line.substr(begin, end - begin);
+}
+
+auto KeyField::field_begin( std::string_view line, std::size_t field ) const noexcept -> std::size_t
+{
+    auto pos = std::size_t{0};
+    for( ; field != 0 && pos != line.size(); --field ){
+        pos = field_end(line, pos);
+        if( m_separator && pos != line.size() ){
+            ++pos;      // the separator belongs to neither field
+        }
+        else if( m_separator ){
+            return line.size();
+        }
+    }
+    return field == 0 ? pos : line.size();
+}
+
+auto KeyField::field_end( std::string_view line, std::size_t begin ) const noexcept -> std::size_t
+{
+    if( m_separator ){
+        return std::min( line.find(*m_separator, begin), line.size() );
+    }
+    auto pos = begin;
+    while( pos != line.size() && is_blank(line[pos]) ){
+        ++pos;
+    }
+    while( pos != line.size() && !is_blank(line[pos]) ){
+        ++pos;
+    }
+    return pos;
+}
+
+
+} // namespace
@@ -0,0 +1,67 @@
+#include "line_buffer.hpp"
+#include <stdexcept>
+#include <limits>
+#include <cstring>
+
+
+namespace jam
+{
+
+
+void LineBuffer::emplace_back( std::string_view line )
+{
+    if( line.size() > std::numeric_limits<std::uint32_t>::max() ){
+        throw std::length_error( "LineBuffer: line too long" );
+    }
+    if( m_chunks.empty() || m_chunk_capacity - m_chunk_used < line.size() ){
+        // Lines longer than a chunk get a chunk of their own
+        m_chunk_capacity = std::max( chunk_size, line.size() );
+        m_chunks.push_back( std::make_unique<char[]>(m_chunk_capacity) );
+        m_chunk_used = 0;
+    }
+    std::memcpy( m_chunks.back().get() + m_chunk_used, line.data(), line.size() );
+    m_index.push_back( Entry{ static_cast<std::uint32_t>(m_chunks.size() - 1),
+                              static_cast<std::uint32_t>(m_chunk_used),
+                              static_cast<std::uint32_t>(line.size()) } );
+    m_chunk_used += line.size();
+    m_bytes += line.size();
+}
+
+void LineBuffer::clear() noexcept
+{
+    m_chunks.clear();
+    m_index.clear();
+    m_chunk_capacity = 0;
+    m_chunk_used = 0;
+    m_bytes = 0;
+}
+
+void LineBuffer::permute( const std::vector<size_type>& order )
+{
+    auto index = std::vector<Entry>{};
+    index.reserve(order.size());
+    for( auto i : order ){
+        index.push_back( m_index[i] );
+    }
+    m_index = std::move(index);
+}
+
+void LineBuffer::write( std::ostream& os ) const
+{
+    constexpr auto block_size = std::size_t{1} << 16;
+    auto block = std::string{};
+    block.reserve(block_size);
+    for( const auto& entry : m_index ){
+        const auto line = view(entry);
+        if( block.size() + line.size() + 1 > block_size && !block.empty() ){
+            os.write( block.data(), static_cast<std::streamsize>(block.size()) );
+            block.clear();
+        }
+        block += line;
+        block += '\n';
+    }
+    os.write( block.data(), static_cast<std::streamsize>(block.size()) );
+}
+
+
+} // namespace
@@ -0,0 +1,172 @@
+#include "line_numberer.hpp"
+#include "line_reader.hpp"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+
+namespace jam
+{
+
+
+namespace
+{
+[[noreturn]] void throw_error( const char* call )
+{
+    throw std::runtime_error( std::string{"Failed to number lines ("} + call + "): " + std::strerror(errno) );
+}
+} // namespace
+
+
+LineNumberer::LineNumberer( int out_fd, Mode mode, std::size_t first, std::size_t block_size )
+    : m_out_fd{out_fd}
+    , m_mode{mode}
+    , m_block(std::max<std::size_t>(block_size, 64))
+    , m_staging(staging_size)
+{
+    m_iovecs.reserve(max_iovecs);
+    char digits[counter_size];
+    const auto end = std::to_chars( digits, digits + sizeof(digits), first ).ptr;
+    const auto length = static_cast<std::size_t>(end - digits);
+    m_counter_begin = counter_digits_end - length;
+    std::memcpy( m_counter + m_counter_begin, digits, length );
+    m_counter[counter_digits_end] = '.';
+    m_counter[counter_digits_end + 1] = '\t';
+}
+
+auto LineNumberer::next_number() const -> std::size_t
+{
+    auto number = std::size_t{0};
+    std::from_chars( m_counter + m_counter_begin, m_counter + counter_digits_end, number );
+    return number;
+}
+
+void LineNumberer::increment() noexcept
+{
+    for( auto i = counter_digits_end; i != m_counter_begin; ){
+        --i;
+        if( m_counter[i] != '9' ){
+            ++m_counter[i];
+            return;
+        }
+        m_counter[i] = '0';
+    }
+    m_counter[--m_counter_begin] = '1';
+}
+
+void LineNumberer::add_prefix()
+{
+    stage( m_counter + m_counter_begin, counter_size - m_counter_begin );
+    increment();
+}
+
+void LineNumberer::add_segment( const char* first, const char* last )
+{
+    const auto length = static_cast<std::size_t>(last - first);
+    if( length < copy_limit ){
+        stage( first, length );
+    }
+    else{
+        add_iovec( first, length );
+    }
+}
+
+void LineNumberer::stage( const char* data, std::size_t length )
+{
+    // Flushing here rather than in add_iovec() keeps the staged bytes ahead
+    // of the next write
+    if( m_staged + length > m_staging.size() || m_iovecs.size() == max_iovecs ){
+        flush();
+    }
+    auto* staged = m_staging.data() + m_staged;
+    std::memcpy( staged, data, length );
+    m_staged += length;
+    add_iovec( staged, length );
+}
+
+void LineNumberer::add_iovec( const char* data, std::size_t length )
+{
+    // Whatever continues the previous piece is written as part of it
+    if( !m_iovecs.empty() ){
+        auto& previous = m_iovecs.back();
+        if( static_cast<const char*>(previous.iov_base) + previous.iov_len == data ){
+            previous.iov_len += length;
+            return;
+        }
+    }
+    if( m_iovecs.size() == max_iovecs ){
+        flush();
+    }
+    m_iovecs.push_back( iovec{const_cast<char*>(data), length} );
+}
+
+void LineNumberer::flush()
+{
+    auto* iov = m_iovecs.data();
+    auto count = m_iovecs.size();
+    while( count != 0 ){
+        auto written = ::writev( m_out_fd, iov, static_cast<int>(count) );
+        if( written == -1 ){
+            if( errno == EINTR )
+                continue;
+            throw_error("writev");
+        }
+        // Skip what got written, a partial write may end inside an iovec
+        while( count != 0 && static_cast<std::size_t>(written) >= iov->iov_len ){
+            written -= static_cast<ssize_t>(iov->iov_len);
+            ++iov;
+            --count;
+        }
+        if( count != 0 ){
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= static_cast<std::size_t>(written);
+        }
+    }
+    m_iovecs.clear();
+    m_staged = 0;
+}
+
+void LineNumberer::number( int in_fd )
+{
+    auto line_begin = true;
+    for( ;; ){
+        const auto got = ::read( in_fd, m_block.data(), m_block.size() );
+        if( got == -1 ){
+            if( errno == EINTR )
+                continue;
+            throw_error("read");
+        }
+        if( got == 0 ){
+            break;
+        }
+
+        const auto* p = m_block.data();
+        const auto* const end = p + got;
+        while( p != end ){
+            if( line_begin ){
+                if( m_mode == Mode::all || *p != '\n' ){
+                    add_prefix();
+                }
+                line_begin = false;
+            }
+            const auto* nl = find_newline( p, end );
+            if( nl == end ){
+                add_segment( p, end );
+                break;
+            }
+            add_segment( p, nl + 1 );
+            p = nl + 1;
+            line_begin = true;
+        }
+        // The segments point into the block, which the next read reuses
+        flush();
+    }
+}
+
+
+} // namespace
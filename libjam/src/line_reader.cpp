@@ -0,0 +1,147 @@
+#include "line_reader.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define JAM_HAVE_X86_SIMD 1
+#endif
+
+
+namespace jam
+{
+
+
+namespace
+{
+
+auto find_newline_memchr( const char* first, const char* last ) noexcept -> const char*
+{
+    const auto* nl = static_cast<const char*>( std::memchr(first, '\n', last - first) );
+    return nl != nullptr ? nl : last;
+}
+
+#if defined(JAM_HAVE_X86_SIMD)
+// SSE2 is part of x86-64, so this one is always available there
+auto find_newline_sse2( const char* first, const char* last ) noexcept -> const char*
+{
+    const auto newline = _mm_set1_epi8('\n');
+    for( ; last - first >= 16; first += 16 ){
+        const auto chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>(first) );
+        const auto mask = _mm_movemask_epi8( _mm_cmpeq_epi8(chunk, newline) );
+        if( mask != 0 ){
+            return first + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+    return find_newline_memchr(first, last);
+}
+
+__attribute__((target("avx2")))
+auto find_newline_avx2( const char* first, const char* last ) noexcept -> const char*
+{
+    const auto newline = _mm256_set1_epi8('\n');
+    // Two vectors per iteration - lines are usually longer than 32 bytes
+    for( ; last - first >= 64; first += 64 ){
+        const auto lo = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(first) );
+        const auto hi = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(first + 32) );
+        const auto lo_eq = _mm256_cmpeq_epi8(lo, newline);
+        const auto hi_eq = _mm256_cmpeq_epi8(hi, newline);
+        if( !_mm256_testz_si256( _mm256_or_si256(lo_eq, hi_eq), _mm256_or_si256(lo_eq, hi_eq) ) ){
+            const auto lo_mask = static_cast<unsigned>( _mm256_movemask_epi8(lo_eq) );
+            if( lo_mask != 0 ){
+                return first + __builtin_ctz(lo_mask);
+            }
+            const auto hi_mask = static_cast<unsigned>( _mm256_movemask_epi8(hi_eq) );
+            return first + 32 + __builtin_ctz(hi_mask);
+        }
+    }
+    return find_newline_sse2(first, last);
+}
+#endif
+
+using FindNewline = auto (*)( const char*, const char* ) noexcept -> const char*;
+
+auto select_find_newline() noexcept -> FindNewline
+{
+#if defined(JAM_HAVE_X86_SIMD)
+    // Runs from a static initializer - the CPU model may not be set up yet
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports("avx2") ){
+        return find_newline_avx2;
+    }
+    return find_newline_sse2;
+#else
+    return find_newline_memchr;
+#endif
+}
+
+const FindNewline find_newline_impl = select_find_newline();
+
+} // namespace
+
+
+auto find_newline( const char* first, const char* last ) noexcept -> const char*
+{
+    return find_newline_impl(first, last);
+}
+
+
+LineReader::LineReader( std::istream& is, std::size_t block_size )
+    : m_is{is}
+    , m_buffer(std::max<std::size_t>(block_size, 64))
+{
+}
+
+auto LineReader::next( std::string_view& line ) -> bool
+{
+    for( ;; ){
+        const auto* data = m_buffer.data();
+        const auto* nl = find_newline( data + m_begin + m_scanned, data + m_end );
+        if( nl != data + m_end ){
+            const auto nl_offset = static_cast<std::size_t>(nl - data);
+            line = std::string_view( data + m_begin, nl_offset - m_begin );
+            m_begin = nl_offset + 1;
+            m_scanned = 0;
+            return true;
+        }
+        m_scanned = m_end - m_begin;
+        if( !fill() ){
+            if( m_begin == m_end ){
+                return false;
+            }
+            // Last line without a trailing newline
+            line = std::string_view( m_buffer.data() + m_begin, m_end - m_begin );
+            m_begin = m_end;
+            m_scanned = 0;
+            return true;
+        }
+    }
+}
+
+auto LineReader::fill() -> bool
+{
+    if( m_eof ){
+        return false;
+    }
+    // Keep the unfinished line, move it to the front and make room after it
+    if( m_begin != 0 ){
+        std::copy( m_buffer.begin() + m_begin, m_buffer.begin() + m_end, m_buffer.begin() );
+        m_end -= m_begin;
+        m_begin = 0;
+    }
+    if( m_end == m_buffer.size() ){
+        m_buffer.resize( m_buffer.size() * 2 );
+    }
+    m_is.read( m_buffer.data() + m_end, static_cast<std::streamsize>(m_buffer.size() - m_end) );
+    const auto count = static_cast<std::size_t>( m_is.gcount() );
+    m_end += count;
+    m_bytes_read += count;
+    if( count == 0 ){
+        m_eof = true;
+        return false;
+    }
+    return true;
+}
+
+
+} // namespace
@@ -0,0 +1,151 @@
+#include "line_writer.hpp"
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace jam
+{
+
+
+LineWriter::LineWriter( const std::string& fname, std::size_t buffer_size )
+    : m_name{ fname.empty() ? std::string{"standard output"} : fname }
+    , m_buffer{ std::make_unique<char[]>(std::max<std::size_t>(buffer_size, 1)) }
+    , m_capacity{ std::max<std::size_t>(buffer_size, 1) }
+    , m_start{ std::chrono::steady_clock::now() }
+    , m_last_flush{ m_start }
+{
+    if( fname.empty() ){
+        // Whatever went through std::cout so far comes first
+        std::cout.flush();
+        m_fd = STDOUT_FILENO;
+        return;
+    }
+    m_fd = ::open( fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666 );
+    if( m_fd == -1 ){
+        throw std::runtime_error( "Failed to open the file " + fname );
+    }
+    m_owns_fd = true;
+}
+
+LineWriter::LineWriter( LineWriter&& other ) noexcept
+    : m_fd{std::exchange(other.m_fd, -1)}
+    , m_owns_fd{std::exchange(other.m_owns_fd, false)}
+    , m_name{std::move(other.m_name)}
+    , m_buffer{std::move(other.m_buffer)}
+    , m_capacity{other.m_capacity}
+    , m_used{std::exchange(other.m_used, 0)}
+    , m_bytes_written{other.m_bytes_written}
+    , m_start{other.m_start}
+    , m_last_flush{other.m_last_flush}
+{
+}
+
+LineWriter& LineWriter::operator=( LineWriter&& other ) noexcept
+{
+    if( this != &other ){
+        close();
+        m_fd = std::exchange(other.m_fd, -1);
+        m_owns_fd = std::exchange(other.m_owns_fd, false);
+        m_name = std::move(other.m_name);
+        m_buffer = std::move(other.m_buffer);
+        m_capacity = other.m_capacity;
+        m_used = std::exchange(other.m_used, 0);
+        m_bytes_written = other.m_bytes_written;
+        m_start = other.m_start;
+        m_last_flush = other.m_last_flush;
+    }
+    return *this;
+}
+
+LineWriter::~LineWriter()
+{
+    close();
+}
+
+void LineWriter::close() noexcept
+{
+    if( m_fd == -1 ){
+        return;
+    }
+    try{
+        flush();
+    }
+    catch( ... ){
+        // Nowhere to report it from a destructor - call flush() to find out
+    }
+    if( m_owns_fd ){
+        ::close(m_fd);
+    }
+    m_fd = -1;
+}
+
+void LineWriter::write_line( std::string_view line )
+{
+    if( m_capacity - m_used > line.size() ){
+        std::memcpy( m_buffer.get() + m_used, line.data(), line.size() );
+        m_used += line.size();
+        m_buffer[m_used++] = '\n';
+        return;
+    }
+    write(line);
+    write("\n");
+}
+
+void LineWriter::write( std::string_view bytes )
+{
+    if( m_capacity - m_used < bytes.size() ){
+        flush();
+        // Larger than the whole buffer - no point in copying it
+        if( bytes.size() >= m_capacity ){
+            write_all( bytes.data(), bytes.size() );
+            return;
+        }
+    }
+    std::memcpy( m_buffer.get() + m_used, bytes.data(), bytes.size() );
+    m_used += bytes.size();
+}
+
+void LineWriter::flush()
+{
+    const auto used = std::exchange(m_used, 0);
+    write_all( m_buffer.get(), used );
+}
+
+void LineWriter::write_all( const char* data, std::size_t size )
+{
+    while( size != 0 ){
+        const auto written = ::write( m_fd, data, size );
+        if( written == -1 ){
+            if( errno == EINTR ){
+                continue;
+            }
+            throw std::runtime_error( "Failed to write to " + m_name + ": " + std::strerror(errno) );
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+        m_bytes_written += static_cast<std::size_t>(written);
+    }
+    m_last_flush = std::chrono::steady_clock::now();
+}
+
+auto LineWriter::bytes_per_second() const noexcept -> double
+{
+    const auto elapsed = std::chrono::duration<double>(m_last_flush - m_start).count();
+    return elapsed > 0 ? static_cast<double>(m_bytes_written) / elapsed : 0.0;
+}
+
+void LineWriter::report( std::ostream& os ) const
+{
+    os << m_name << ": " << m_bytes_written << " bytes, "
+       << bytes_per_second() / (1 << 20) << " MiB/s\n";
+}
+
+
+} // namespace
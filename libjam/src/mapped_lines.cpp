@@ -0,0 +1,112 @@
+#include "mapped_lines.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace jam
+{
+
+
+auto MappedLines::can_map( const std::string& fname ) noexcept -> bool
+{
+    struct stat st{};
+    return ::stat( fname.c_str(), &st ) == 0 && S_ISREG(st.st_mode) && st.st_size > 0;
+}
+
+MappedLines::MappedLines( const std::string& fname )
+{
+    const auto fd = ::open( fname.c_str(), O_RDONLY );
+    if( fd == -1 ){
+        throw std::runtime_error( "Failed to open the file " + fname );
+    }
+    struct stat st{};
+    if( ::fstat(fd, &st) == -1 ){
+        ::close(fd);
+        throw std::runtime_error( "Failed to stat the file " + fname );
+    }
+    if( !S_ISREG(st.st_mode) ){
+        ::close(fd);
+        throw std::runtime_error( "Failed to map the file " + fname + ", it is no regular file" );
+    }
+    m_size = static_cast<size_type>(st.st_size);
+    if( m_size == 0 ){
+        // Files of /proc and /sys report no size whatever they hold - only
+        // one that has nothing to read is really empty
+        auto ch = char{};
+        const auto read = ::read( fd, &ch, 1 );
+        ::close(fd);
+        if( read != 0 ){
+            throw std::runtime_error( "Failed to map the file " + fname + ", its size is unknown" );
+        }
+        build_index();
+        return;
+    }
+    auto* addr = ::mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( addr == MAP_FAILED ){
+        ::close(fd);
+        throw std::runtime_error( "Failed to map the file " + fname );
+    }
+    ::madvise( addr, m_size, MADV_SEQUENTIAL );
+    m_data = static_cast<const char*>(addr);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    build_index();
+}
+
+MappedLines::MappedLines( MappedLines&& other ) noexcept
+    : m_data{std::exchange(other.m_data, nullptr)}
+    , m_size{std::exchange(other.m_size, 0)}
+    , m_offsets{std::exchange(other.m_offsets, {0})}
+{
+}
+
+MappedLines& MappedLines::operator=( MappedLines&& other ) noexcept
+{
+    if( this != &other ){
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_offsets = std::exchange(other.m_offsets, {0});
+    }
+    return *this;
+}
+
+MappedLines::~MappedLines()
+{
+    unmap();
+}
+
+void MappedLines::build_index()
+{
+    m_offsets.clear();
+    m_offsets.push_back(0);
+    const auto* const end = m_data + m_size;
+    for( const auto* p = m_data; p != end; ){
+        const auto* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if( nl == nullptr ){
+            // Last line without a trailing newline - pretend there is one so
+            // every line length is (next offset - offset - 1)
+            m_offsets.push_back(m_size + 1);
+            break;
+        }
+        p = nl + 1;
+        m_offsets.push_back(static_cast<size_type>(p - m_data));
+    }
+}
+
+void MappedLines::unmap() noexcept
+{
+    if( m_data != nullptr ){
+        ::munmap( const_cast<char*>(m_data), m_size );
+        m_data = nullptr;
+    }
+}
+
+
+} // namespace
@@ -0,0 +1,227 @@
+#include "pipeline.hpp"
+#include <future>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <stdexcept>
+
+
+namespace jam
+{
+
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+auto nanoseconds_since( Clock::time_point start ) -> std::uint64_t
+{
+    return static_cast<std::uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       Clock::now() - start).count() );
+}
+
+// Thrown at the reader when a later stage gave up - ends the reader quietly,
+// the error that caused it is reported by the stage that threw it
+struct PipelineStopped { };
+} // namespace
+
+
+auto StageStats::lines_per_second() const noexcept -> double
+{
+    const auto busy = busy_nanoseconds.load();
+    return busy != 0 ? static_cast<double>(lines_out.load()) * 1e9 / static_cast<double>(busy) : 0.0;
+}
+
+auto StageStats::bytes_per_second() const noexcept -> double
+{
+    const auto busy = busy_nanoseconds.load();
+    return busy != 0 ? static_cast<double>(bytes_out.load()) * 1e9 / static_cast<double>(busy) : 0.0;
+}
+
+auto operator<<( std::ostream& os, const StageStats& stats ) -> std::ostream&
+{
+    const auto flags = os.flags();
+    os << stats.name << ": " << stats.lines_in.load() << " lines in, "
+       << stats.lines_out.load() << " lines out, "
+       << std::fixed << std::setprecision(1)
+       << static_cast<double>(stats.bytes_out.load()) / (1 << 20) << " MiB out, "
+       << stats.bytes_per_second() / (1 << 20) << " MiB/s, "
+       << std::setprecision(3) << static_cast<double>(stats.busy_nanoseconds.load()) / 1e9 << " s busy";
+    os.flags(flags);
+    return os;
+}
+
+
+Pipeline::BatchSink::BatchSink( Queue& queue, StageStats& stats, std::size_t batch_size )
+    : m_queue{queue}
+    , m_stats{stats}
+    , m_batch_size{batch_size}
+{
+    m_batch.reserve(m_batch_size);
+}
+
+void Pipeline::BatchSink::emplace_back( std::string&& line )
+{
+    m_stats.lines_out.fetch_add(1, std::memory_order_relaxed);
+    m_stats.bytes_out.fetch_add(line.size() + 1, std::memory_order_relaxed);
+    m_batch.push_back(std::move(line));
+    if( m_batch.size() == m_batch_size ){
+        flush();
+    }
+}
+
+void Pipeline::BatchSink::flush()
+{
+    if( m_batch.empty() ){
+        return;
+    }
+    const auto start = Clock::now();
+    const auto pushed = m_queue.push( std::move(m_batch) );
+    m_waiting += nanoseconds_since(start);
+    if( !pushed ){
+        throw PipelineStopped{};
+    }
+    m_batch = Batch{};
+    m_batch.reserve(m_batch_size);
+}
+
+
+Pipeline::Pipeline( std::size_t queue_capacity, std::size_t batch_size )
+    : m_queue_capacity{queue_capacity}
+    , m_batch_size{ batch_size != 0 ? batch_size : 1 }
+{
+}
+
+auto Pipeline::add_stage( std::string name, std::function<void(Batch&)> process ) -> Pipeline&
+{
+    m_stages.push_back( Stage{ std::move(name), std::move(process) } );
+    return *this;
+}
+
+void Pipeline::run_stages( std::function<void(BatchSink&)> read, std::ostream& os )
+{
+    m_stats.clear();
+    m_stats.push_back( std::make_unique<StageStats>("read") );
+    for( const auto& stage : m_stages ){
+        m_stats.push_back( std::make_unique<StageStats>(stage.name) );
+    }
+    m_stats.push_back( std::make_unique<StageStats>("write") );
+
+    // queues[i] feeds stage i + 1, counting the reader as stage 0
+    auto queues = std::vector<std::unique_ptr<Queue>>{};
+    for( std::size_t i = 0; i != m_stages.size() + 1; ++i ){
+        queues.push_back( std::make_unique<Queue>(m_queue_capacity) );
+    }
+
+    auto futures = std::vector<std::future<void>>{};
+
+    futures.push_back( std::async( std::launch::async, [&]{
+        auto& out = *queues.front();
+        auto& stats = *m_stats.front();
+        auto sink = BatchSink{ out, stats, m_batch_size };
+        // Time spent blocked on a full queue is not the reader's own
+        const auto start = Clock::now();
+        const auto busy = [&]{ return nanoseconds_since(start) - sink.waiting_nanoseconds(); };
+        try{
+            read(sink);
+            sink.flush();
+        }
+        catch( const PipelineStopped& ){
+        }
+        catch( ... ){
+            stats.busy_nanoseconds.store( busy() );
+            out.close();
+            throw;
+        }
+        stats.busy_nanoseconds.store( busy() );
+        out.close();
+    }));
+
+    for( std::size_t i = 0; i != m_stages.size(); ++i ){
+        futures.push_back( std::async( std::launch::async, [&, i]{
+            auto& in = *queues[i];
+            auto& out = *queues[i + 1];
+            auto& stats = *m_stats[i + 1];
+            auto& process = m_stages[i].process;
+            try{
+                for( auto batch = Batch{}; in.pop(batch); ){
+                    const auto start = Clock::now();
+                    stats.lines_in.fetch_add( batch.size(), std::memory_order_relaxed );
+                    process(batch);
+                    auto bytes = std::uint64_t{0};
+                    for( const auto& line : batch ){
+                        bytes += line.size() + 1;
+                    }
+                    stats.lines_out.fetch_add( batch.size(), std::memory_order_relaxed );
+                    stats.bytes_out.fetch_add( bytes, std::memory_order_relaxed );
+                    stats.busy_nanoseconds.fetch_add( nanoseconds_since(start), std::memory_order_relaxed );
+                    if( !batch.empty() && !out.push(std::move(batch)) ){
+                        break;
+                    }
+                    batch = Batch{};
+                }
+            }
+            catch( ... ){
+                in.close();
+                out.close();
+                throw;
+            }
+            // Downstream stopped early - let the stages before this one know
+            in.close();
+            out.close();
+        }));
+    }
+
+    futures.push_back( std::async( std::launch::async, [&]{
+        auto& in = *queues.back();
+        auto& stats = *m_stats.back();
+        try{
+            for( auto batch = Batch{}; in.pop(batch); ){
+                const auto start = Clock::now();
+                stats.lines_in.fetch_add( batch.size(), std::memory_order_relaxed );
+                auto bytes = std::uint64_t{0};
+                for( const auto& line : batch ){
+                    os.write( line.data(), static_cast<std::streamsize>(line.size()) );
+                    os.put('\n');
+                    bytes += line.size() + 1;
+                }
+                if( !os ){
+                    throw std::runtime_error( "Failed to write the pipeline output" );
+                }
+                stats.lines_out.fetch_add( batch.size(), std::memory_order_relaxed );
+                stats.bytes_out.fetch_add( bytes, std::memory_order_relaxed );
+                stats.busy_nanoseconds.fetch_add( nanoseconds_since(start), std::memory_order_relaxed );
+            }
+        }
+        catch( ... ){
+            in.close();
+            throw;
+        }
+    }));
+
+    auto error = std::exception_ptr{};
+    for( auto& future : futures ){
+        try{
+            future.get();
+        }
+        catch( ... ){
+            if( !error ){
+                error = std::current_exception();
+            }
+        }
+    }
+    os.flush();
+    if( error ){
+        std::rethrow_exception(error);
+    }
+}
+
+void Pipeline::report( std::ostream& os ) const
+{
+    for( const auto& stats : m_stats ){
+        os << *stats << '\n';
+    }
+}
+
+
+} // namespace
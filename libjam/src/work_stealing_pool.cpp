@@ -0,0 +1,138 @@
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+#include <utility>
+
+
+namespace jam
+{
+
+
+namespace
+{
+// The pool and the worker the current thread belongs to, if any
+thread_local const WorkStealingPool* t_pool{nullptr};
+thread_local std::size_t t_worker{0};
+} // namespace
+
+
+WorkStealingPool::WorkStealingPool( unsigned threads )
+{
+    if( threads == 0 ){
+        threads = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+    for( unsigned i = 0; i != threads; ++i ){
+        m_workers.push_back( std::make_unique<Worker>() );
+    }
+    for( std::size_t i = 0; i != m_workers.size(); ++i ){
+        m_workers[i]->thread = std::thread{ [this, i]{ work(i); } };
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        auto lock = std::unique_lock<std::mutex>{m_mutex};
+        m_all_done.wait( lock, [this]{ return m_pending == 0; } );
+        m_stop = true;
+    }
+    m_work_available.notify_all();
+    for( auto& worker : m_workers ){
+        worker->thread.join();
+    }
+}
+
+void WorkStealingPool::submit( Task task )
+{
+    const auto index = t_pool == this ? t_worker
+                                      : m_next_worker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+    m_pending.fetch_add(1);
+    {
+        // Counted before it is queued, so the count never drops below zero.
+        // Taking the lock orders this with a worker about to go to sleep.
+        auto lock = std::lock_guard<std::mutex>{m_mutex};
+        m_queued.fetch_add(1);
+    }
+    {
+        auto& worker = *m_workers[index];
+        auto lock = std::lock_guard<std::mutex>{worker.mutex};
+        worker.tasks.push_back(std::move(task));
+    }
+    m_work_available.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    auto lock = std::unique_lock<std::mutex>{m_mutex};
+    m_all_done.wait( lock, [this]{ return m_pending == 0; } );
+    if( m_error ){
+        std::rethrow_exception( std::exchange(m_error, nullptr) );
+    }
+}
+
+auto WorkStealingPool::pop( std::size_t index, Task& task ) -> bool
+{
+    auto& worker = *m_workers[index];
+    auto lock = std::lock_guard<std::mutex>{worker.mutex};
+    if( worker.tasks.empty() ){
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+auto WorkStealingPool::steal( std::size_t index, Task& task ) -> bool
+{
+    for( std::size_t i = 1; i != m_workers.size(); ++i ){
+        auto& victim = *m_workers[(index + i) % m_workers.size()];
+        auto lock = std::lock_guard<std::mutex>{victim.mutex};
+        if( !victim.tasks.empty() ){
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run( Task& task )
+{
+    m_queued.fetch_sub(1);
+    try{
+        task();
+    }
+    catch( ... ){
+        auto lock = std::lock_guard<std::mutex>{m_mutex};
+        if( !m_error ){
+            m_error = std::current_exception();
+        }
+    }
+    task = nullptr;
+    if( m_pending.fetch_sub(1) == 1 ){
+        {
+            auto lock = std::lock_guard<std::mutex>{m_mutex};
+        }
+        m_all_done.notify_all();
+    }
+}
+
+void WorkStealingPool::work( std::size_t index )
+{
+    t_pool = this;
+    t_worker = index;
+    for( auto task = Task{}; ; ){
+        if( pop(index, task) || steal(index, task) ){
+            run(task);
+            continue;
+        }
+        auto lock = std::unique_lock<std::mutex>{m_mutex};
+        m_work_available.wait( lock, [this]{ return m_stop || m_queued != 0; } );
+        if( m_stop && m_queued == 0 ){
+            return;
+        }
+    }
+}
+
+
+} // namespace
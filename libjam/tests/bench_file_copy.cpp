@@ -0,0 +1,78 @@
+#include "jam/file_copy.hpp"
+#include "jam/external_sort.hpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Copies a file the way cat used to - one char at a time through iostreams -
+// and with every jam::copy_fd method, into a file on the same filesystem.
+// usage: bench_file_copy [FILE]
+// Without a FILE a 256 MiB file is generated first.
+
+namespace
+{
+void make_file( const std::string& path, std::size_t bytes )
+{
+    auto block = std::string(1 << 20, '\0');
+    for( std::size_t i = 0; i != block.size(); ++i ){
+        block[i] = i % 64 == 63 ? '\n' : static_cast<char>('a' + i % 26);
+    }
+    auto ofs = std::ofstream{path, std::ios::binary};
+    for( std::size_t written = 0; written < bytes; written += block.size() ){
+        ofs << block;
+    }
+}
+
+template<typename Function>
+void measure( const std::string& name, Function copy )
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto bytes = copy();
+    const auto elapsed = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << bytes / elapsed / 1e6 << " MB/s\n";
+}
+} // namespace
+
+
+int main( int argc, char* argv[] )
+{
+    auto generated = jam::TemporaryFile{};
+    auto path = std::string{};
+    if( argc > 1 ){
+        path = argv[1];
+    }
+    else{
+        path = generated.path();
+        make_file(path, std::size_t{256} << 20);
+    }
+    auto output = jam::TemporaryFile{};
+
+    measure( "byte loop      ", [&]{
+        auto ifs = std::ifstream{path, std::ios::binary};
+        auto ofs = std::ofstream{output.path(), std::ios::binary};
+        auto bytes = std::size_t{0};
+        for( char ch; ifs.get(ch); ++bytes ){
+            ofs << ch;
+        }
+        return bytes;
+    });
+
+    for( auto method : { jam::CopyMethod::read_write, jam::CopyMethod::sendfile,
+                         jam::CopyMethod::splice, jam::CopyMethod::copy_file_range } ){
+        measure( std::string{jam::to_string(method)} + std::string(15 - std::string{jam::to_string(method)}.size(), ' '), [&]{
+            const auto in_fd = ::open(path.c_str(), O_RDONLY);
+            const auto out_fd = ::open(output.path().c_str(), O_WRONLY | O_TRUNC);
+            const auto bytes = jam::copy_fd(in_fd, out_fd, method);
+            ::close(in_fd);
+            ::close(out_fd);
+            return bytes;
+        });
+    }
+}
@@ -0,0 +1,70 @@
+#include "jam/glob.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <regex>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+// Matches random file names against glob patterns with jam::Glob, and
+// against the same patterns written as regular expressions with
+// std::regex_search - what find --name used to do.
+// usage: bench_glob [NAMES]
+
+namespace
+{
+auto make_names( std::size_t count ) -> std::vector<std::string>
+{
+    const char* stems[] = { "main", "test_parser", "README", "build", "log", "a_x", "changelog" };
+    const char* extensions[] = { ".txt", ".cpp", ".hpp", ".log", "", ".tar.gz" };
+    auto generator = std::mt19937{42};
+    auto pick = std::uniform_int_distribution<std::size_t>(0, 1000);
+    auto names = std::vector<std::string>{};
+    names.reserve(count);
+    for( std::size_t i = 0; i != count; ++i ){
+        names.push_back( std::string{stems[pick(generator) % 7]} + std::to_string(pick(generator))
+                         + extensions[pick(generator) % 6] );
+    }
+    return names;
+}
+
+template<typename Function>
+void measure( const std::string& name, const std::vector<std::string>& names, Function match )
+{
+    const auto start = std::chrono::steady_clock::now();
+    auto matches = std::size_t{0};
+    for( const auto& file_name : names ){
+        matches += match(file_name) ? 1 : 0;
+    }
+    const auto elapsed = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << name << ": " << matches << " matches, "
+              << static_cast<double>(names.size()) / elapsed / 1e6 << " M names/s\n";
+}
+} // namespace
+
+
+int main( int argc, char* argv[] )
+{
+    const auto count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000ul;
+    const auto names = make_names(count);
+
+    const std::pair<const char*, const char*> patterns[] = {
+        { "*.txt", "\\.txt$" },
+        { "test_*", "^test_" },
+        { "*log*", "log" },
+        { "[a-c]*_?[0-9]*.?pp", "^[a-c].*_.[0-9].*\\..pp$" },
+    };
+    for( const auto& [glob, regex] : patterns ){
+        std::cout << glob << '\n';
+        const auto re = std::regex{regex};
+        measure( "std::regex_search", names, [&]( const std::string& name ){
+            return std::regex_search(name, re);
+        });
+        const auto matcher = jam::Glob{glob};
+        measure( "jam::Glob        ", names, [&]( const std::string& name ){
+            return matcher(name);
+        });
+    }
+}
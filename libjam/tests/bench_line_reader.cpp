@@ -0,0 +1,77 @@
+#include "jam/line_reader.hpp"
+#include "jam/external_sort.hpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+// Splits a file into lines with getline() and with jam::LineReader.
+// usage: bench_line_reader [FILE]
+// Without a FILE a 512 MiB file of random lines is generated first.
+
+namespace
+{
+void make_file( const std::string& path, std::size_t bytes )
+{
+    auto ofs = std::ofstream{path, std::ios::binary};
+    auto generator = std::mt19937{42};
+    auto letter = std::uniform_int_distribution<int>('a', 'z');
+    auto length = std::uniform_int_distribution<std::size_t>(8, 120);
+    for( std::size_t written = 0; written < bytes; ){
+        auto line = std::string(length(generator), ' ');
+        for( auto& ch : line ){
+            ch = static_cast<char>(letter(generator));
+        }
+        line += '\n';
+        ofs << line;
+        written += line.size();
+    }
+}
+
+template<typename Function>
+void measure( const char* name, const std::string& path, Function count_lines )
+{
+    auto ifs = std::ifstream{path, std::ios::binary};
+    const auto start = std::chrono::steady_clock::now();
+    const auto [lines, bytes] = count_lines(ifs);
+    const auto elapsed = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << lines << " lines, "
+              << bytes / elapsed / 1e9 << " GB/s\n";
+}
+} // namespace
+
+
+int main( int argc, char* argv[] )
+{
+    auto generated = jam::TemporaryFile{};
+    auto path = std::string{};
+    if( argc > 1 ){
+        path = argv[1];
+    }
+    else{
+        path = generated.path();
+        make_file(path, std::size_t{512} << 20);
+    }
+
+    measure( "getline   ", path, []( std::istream& is ){
+        auto lines = std::size_t{0};
+        auto bytes = std::size_t{0};
+        for( std::string line; getline(is, line); ){
+            ++lines;
+            bytes += line.size() + 1;
+        }
+        return std::pair{lines, bytes};
+    });
+    measure( "LineReader", path, []( std::istream& is ){
+        auto lines = std::size_t{0};
+        auto reader = jam::LineReader{is};
+        for( std::string_view line; reader.next(line); ){
+            ++lines;
+        }
+        return std::pair{lines, reader.bytes_read()};
+    });
+}
@@ -0,0 +1,56 @@
+#include "jam/jam.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <cstdlib>
+
+// Sorts the same set of random lines with an increasing number of threads.
+// usage: bench_sort_lines [LINES] [MAX_THREADS]
+
+namespace
+{
+auto make_lines( std::size_t count ) -> std::vector<std::string>
+{
+    auto lines = std::vector<std::string>{};
+    lines.reserve(count);
+    auto generator = std::mt19937{42};
+    auto letter = std::uniform_int_distribution<int>('a', 'z');
+    auto length = std::uniform_int_distribution<std::size_t>(8, 80);
+    for( std::size_t i = 0; i != count; ++i ){
+        auto line = std::string(length(generator), ' ');
+        for( auto& ch : line ){
+            ch = static_cast<char>(letter(generator));
+        }
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+} // namespace
+
+
+int main( int argc, char* argv[] )
+{
+    const auto count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000ull;
+    const auto input = make_lines(count);
+    const auto max_threads = argc > 2
+                                ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                                : std::max( std::thread::hardware_concurrency(), 1u );
+
+    double baseline{0};
+    for( auto threads = 1u; threads <= max_threads; threads *= 2 ){
+        auto lines = input;
+        const auto start = std::chrono::steady_clock::now();
+        jam::sort_lines( lines, std::less<std::string>(), threads );
+        const auto elapsed = std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - start).count();
+        if( threads == 1 ){
+            baseline = elapsed;
+        }
+        std::cout << threads << " threads: " << elapsed << " s"
+                  << "  speedup " << baseline / elapsed << "x\n";
+    }
+}
@@ -0,0 +1,110 @@
+#include "jam/work_stealing_pool.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+// Walks a synthetic directory tree, counting the files with a ".txt"
+// extension, with one std::async per subdirectory and with the
+// WorkStealingPool.
+// usage: bench_work_stealing_pool [FILES [THREADS]]
+// The tree - FILES files (1M by default), 10 per directory, 10
+// subdirectories per directory - is generated in a temporary directory and
+// removed afterwards.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+void make_tree( const fs::path& root, std::size_t files )
+{
+    auto directories = std::vector<fs::path>{ root };
+    fs::create_directory(root);
+    for( std::size_t made = 0, next = 0; made < files; ++next ){
+        const auto directory = directories[next];
+        for( int i = 0; i != 10 && made < files; ++i, ++made ){
+            std::ofstream{ directory / ("file" + std::to_string(made) + (made % 3 ? ".cpp" : ".txt")) };
+        }
+        for( int i = 0; i != 10; ++i ){
+            auto subdirectory = directory / ("dir" + std::to_string(i));
+            fs::create_directory(subdirectory);
+            directories.push_back(std::move(subdirectory));
+        }
+    }
+}
+
+auto is_match( const fs::directory_entry& entry ) -> bool
+{
+    return entry.is_regular_file() && entry.path().extension() == ".txt";
+}
+
+auto async_count( const fs::path& directory ) -> std::size_t
+{
+    auto futures = std::vector<std::future<std::size_t>>{};
+    auto count = std::size_t{0};
+    for( const auto& entry : fs::directory_iterator(directory) ){
+        if( entry.is_directory() ){
+            futures.push_back( std::async(async_count, entry.path()) );
+        }
+        else if( is_match(entry) ){
+            ++count;
+        }
+    }
+    for( auto& future : futures ){
+        count += future.get();
+    }
+    return count;
+}
+
+void pool_count( jam::WorkStealingPool& pool, const fs::path& directory, std::atomic<std::size_t>& count )
+{
+    auto local = std::size_t{0};
+    for( const auto& entry : fs::directory_iterator(directory) ){
+        if( entry.is_directory() ){
+            pool.submit( [&pool, path = entry.path(), &count]{ pool_count(pool, path, count); } );
+        }
+        else if( is_match(entry) ){
+            ++local;
+        }
+    }
+    count.fetch_add(local, std::memory_order_relaxed);
+}
+
+template<typename Function>
+void measure( const char* name, Function count_files )
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto count = count_files();
+    const auto elapsed = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << count << " matches in " << elapsed << " s\n";
+}
+} // namespace
+
+
+int main( int argc, char* argv[] )
+{
+    const auto files = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000ul;
+    const auto threads = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 0u;
+    const auto root = fs::temp_directory_path() / ("bench_work_stealing_pool." + std::to_string(::getpid()));
+
+    make_tree(root, files);
+
+    measure( "std::async per directory", [&]{ return async_count(root); } );
+    measure( "work-stealing pool      ", [&]{
+        auto pool = jam::WorkStealingPool{threads};
+        auto count = std::atomic<std::size_t>{0};
+        pool.submit( [&]{ pool_count(pool, root, count); } );
+        pool.wait();
+        return count.load();
+    });
+
+    fs::remove_all(root);
+}
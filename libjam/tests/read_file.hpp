@@ -0,0 +1,19 @@
+#ifndef JAM_TESTS_READ_FILE_INCLUDED_HPP_
+#define JAM_TESTS_READ_FILE_INCLUDED_HPP_
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+
+// The whole contents of fname, byte for byte
+inline auto read_file( const std::string& fname ) -> std::string
+{
+    auto ifs = std::ifstream{fname, std::ios::binary};
+    auto ss = std::ostringstream{};
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+
+#endif /* JAM_TESTS_READ_FILE_INCLUDED_HPP_ */
@@ -0,0 +1,44 @@
+#ifndef JAM_TESTS_TEMPORARY_DIRECTORY_INCLUDED_HPP_
+#define JAM_TESTS_TEMPORARY_DIRECTORY_INCLUDED_HPP_
+
+#include "jam/directory_reader.hpp"
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+#include <stdlib.h>
+
+
+// A uniquely named directory that removes itself, with all it holds
+class TemporaryDirectory
+{
+public:
+    explicit TemporaryDirectory( const std::string& prefix = "jam_test" )
+    {
+        auto pattern = (std::filesystem::temp_directory_path() / (prefix + ".XXXXXX")).string();
+        if( ::mkdtemp( pattern.data() ) == nullptr )
+            throw std::runtime_error( "Failed to create a temporary directory " + pattern );
+        m_path = pattern;
+    }
+    TemporaryDirectory( const TemporaryDirectory& ) = delete;
+    TemporaryDirectory& operator=( const TemporaryDirectory& ) = delete;
+    ~TemporaryDirectory()
+    {
+        auto error = std::error_code{};
+        std::filesystem::remove_all( m_path, error );
+    }
+
+    auto path() const -> const std::filesystem::path& { return m_path; }
+private:
+    std::filesystem::path m_path;
+};
+
+// Matches every entry of a walk
+inline auto everything( std::string_view, jam::DirectoryEntry& ) -> bool
+{
+    return true;
+}
+
+
+#endif /* JAM_TESTS_TEMPORARY_DIRECTORY_INCLUDED_HPP_ */
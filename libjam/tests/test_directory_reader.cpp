@@ -0,0 +1,64 @@
+#include "catch/catch.hpp"
+#include "jam/directory_reader.hpp"
+#include "temporary_directory.hpp"
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <stdexcept>
+
+#include <fcntl.h>
+
+namespace fs = std::filesystem;
+
+
+TEST_CASE( "DirectoryReader lists a directory with the entry types" )
+{
+    auto directory = TemporaryDirectory{ "jam_test_dir" };
+    const auto& root = directory.path();
+    std::ofstream{ root / "file" } << "12345";
+    fs::create_directory( root / "subdirectory" );
+    fs::create_symlink( root / "file", root / "link" );
+    for( int i = 0; i != 500; ++i ){
+        std::ofstream{ root / ("many." + std::to_string(i)) };
+    }
+
+    auto reader = jam::DirectoryReader{ root.string(), 1024 };
+    auto entries = std::map<std::string, jam::EntryType>{};
+    for( auto entry = jam::DirectoryEntry{}; reader.next(entry); ){
+        entries.emplace( entry.name(), entry.type() );
+        if( entry.name() == "file" ){
+            REQUIRE( entry.status().st_size == 5 );
+            REQUIRE( entry.inode() == entry.status().st_ino );
+        }
+    }
+
+    REQUIRE( entries.size() == 503 );
+    REQUIRE( entries.count(".") == 0 );
+    REQUIRE( entries.count("..") == 0 );
+    REQUIRE( entries["file"] == jam::EntryType::regular );
+    REQUIRE( entries["subdirectory"] == jam::EntryType::directory );
+    REQUIRE( entries["link"] == jam::EntryType::symlink );
+    REQUIRE( entries["many.499"] == jam::EntryType::regular );
+
+    SECTION( "relative to a directory descriptor" ){
+        auto subdirectory = jam::DirectoryReader{ reader.fd(), "subdirectory" };
+        auto entry = jam::DirectoryEntry{};
+        REQUIRE_FALSE( subdirectory.next(entry) );
+    }
+
+    SECTION( "entries that were not listed" ){
+        const auto path = (root / "file").string();
+        auto entry = jam::DirectoryEntry{ AT_FDCWD, path };
+        REQUIRE( entry.type() == jam::EntryType::regular );
+        REQUIRE( entry.status().st_size == 5 );
+        auto known = jam::DirectoryEntry{ AT_FDCWD, path, jam::EntryType::symlink };
+        REQUIRE( known.type() == jam::EntryType::symlink );
+        REQUIRE_FALSE( known.has_status() );
+    }
+
+    SECTION( "errors" ){
+        REQUIRE_THROWS_AS( jam::DirectoryReader{ (root / "file").string() }, std::runtime_error );
+        REQUIRE_THROWS_AS( jam::DirectoryReader{ (root / "none").string() }, std::runtime_error );
+    }
+}
@@ -0,0 +1,157 @@
+#include "catch/catch.hpp"
+#include "jam/external_sort.hpp"
+#include <string>
+#include <vector>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <cctype>
+#include <cstdio>
+
+using std::vector;
+using std::string;
+
+namespace
+{
+auto make_input( std::size_t count ) -> vector<string>
+{
+    auto lines = vector<string>{};
+    auto generator = std::mt19937{7};
+    auto letter = std::uniform_int_distribution<int>('A', 'z');
+    auto length = std::uniform_int_distribution<std::size_t>(0, 20);
+    for( std::size_t i = 0; i != count; ++i ){
+        auto line = string(length(generator), ' ');
+        for( auto& ch : line ){
+            ch = static_cast<char>(letter(generator));
+        }
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+auto join( const vector<string>& lines ) -> string
+{
+    auto result = string{};
+    for( const auto& line : lines ){
+        result += line + '\n';
+    }
+    return result;
+}
+} // namespace
+
+
+TEST_CASE( "TemporaryFile", "[external_sort]" )
+{
+    auto path = string{};
+    {
+        auto file = jam::TemporaryFile{};
+        path = file.path();
+        REQUIRE( std::ifstream{path}.is_open() );
+    }
+    REQUIRE_FALSE( std::ifstream{path}.is_open() );
+}
+
+TEST_CASE( "TemporaryFile replaces a file it was written from", "[external_sort]" )
+{
+    auto input = jam::TemporaryFile{};
+    std::ofstream{input.path()} << "b\na\n";
+    auto path = string{};
+    {
+        auto ifs = std::ifstream{input.path()};
+        auto output = jam::TemporaryFile{};
+        path = output.path();
+        REQUIRE( jam::same_file(input.path(), input.path()) );
+        REQUIRE_FALSE( jam::same_file(input.path(), output.path()) );
+        REQUIRE_FALSE( jam::same_file(input.path(), "/nonexistent/file") );
+
+        auto lines = jam::get_lines<vector<string>>(ifs);
+        std::sort(lines.begin(), lines.end());
+        std::ofstream{output.path()} << join(lines);
+        output.keep_as(input.path());
+    }
+    REQUIRE_FALSE( std::ifstream{path}.is_open() );
+    auto ifs = std::ifstream{input.path()};
+    REQUIRE( jam::get_lines<vector<string>>(ifs) == vector<string>{"a", "b"} );
+}
+
+TEST_CASE( "external_sort", "[external_sort]" )
+{
+    const auto input = make_input(5000);
+
+    SECTION( "input fitting the budget is sorted in memory" ){
+        auto sorter = jam::ExternalSorter<std::less<string>>{ {}, 1 << 30 };
+        for( const auto& line : input ){
+            sorter.push_back(line);
+        }
+        auto os = std::ostringstream{};
+        sorter.write(os);
+        REQUIRE( sorter.runs() == 0 );
+        auto expected = input;
+        std::sort(expected.begin(), expected.end());
+        REQUIRE( os.str() == join(expected) );
+    }
+
+    SECTION( "runs are spilled and merged" ){
+        auto is = std::istringstream{join(input)};
+        auto os = std::ostringstream{};
+        jam::external_sort(is, os, std::greater<string>(), 4096);
+        auto expected = input;
+        std::sort(expected.begin(), expected.end(), std::greater<string>());
+        REQUIRE( os.str() == join(expected) );
+    }
+
+    SECTION( "more runs than can be merged at once" ){
+        auto sorter = jam::ExternalSorter<std::less<string>>{ {}, 512 };
+        auto is = std::istringstream{join(input)};
+        jam::get_lines(is, sorter);
+        REQUIRE( sorter.runs() > sorter.max_merge_runs );
+        auto os = std::ostringstream{};
+        sorter.write(os);
+        auto expected = input;
+        std::sort(expected.begin(), expected.end());
+        REQUIRE( os.str() == join(expected) );
+    }
+
+    SECTION( "wrapped predicates" ){
+        auto to_upper = []( const string& s ){
+            auto result = s;
+            std::transform(result.begin(), result.end(), result.begin(),
+                           [](unsigned char ch){ return std::toupper(ch); });
+            return result;
+        };
+        auto is = std::istringstream{join(input)};
+        auto os = std::ostringstream{};
+        jam::external_sort(is, os,
+            jam::wrap_binary_predicate(std::less<string>(), to_upper), 2048);
+        auto result = std::istringstream{os.str()};
+        auto lines = jam::get_lines<vector<string>>(result);
+        REQUIRE( lines.size() == input.size() );
+        REQUIRE( std::is_sorted(lines.cbegin(), lines.cend(),
+            [&]( const string& lhs, const string& rhs ){
+                return to_upper(lhs) < to_upper(rhs);
+            }) );
+    }
+
+    SECTION( "the budget covers the allocations and the sort" ){
+        auto sorter = jam::ExternalSorter<std::less<string>>{ {}, 1 << 16 };
+        auto bytes = std::size_t{0};
+        for( const auto& line : input ){
+            bytes += sizeof(string) + line.size();
+            sorter.push_back(line);
+        }
+        // Counting the characters and the strings alone would need half
+        // as many runs at most
+        REQUIRE( sorter.runs() > 2 * (bytes >> 16) );
+    }
+
+    SECTION( "write errors" ){
+        auto sorter = jam::ExternalSorter<std::less<string>>{ {}, 4096 };
+        for( const auto& line : input ){
+            sorter.push_back(line);
+        }
+        auto os = std::ostringstream{};
+        os.setstate(std::ios::badbit);
+        REQUIRE_THROWS_AS( sorter.write(os), std::runtime_error );
+    }
+}
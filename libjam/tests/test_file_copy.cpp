@@ -0,0 +1,91 @@
+#include "catch/catch.hpp"
+#include "jam/file_copy.hpp"
+#include "jam/external_sort.hpp"
+#include "read_file.hpp"
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+auto make_content( std::size_t size ) -> std::string
+{
+    auto content = std::string(size, '\0');
+    for( std::size_t i = 0; i != size; ++i ){
+        content[i] = static_cast<char>('a' + i * 7 % 26);
+    }
+    return content;
+}
+
+// Copies the whole input, then again from an offset after a few bytes that
+// are in the output already
+void check_copy( jam::CopyMethod method, const std::string& input, const std::string& content )
+{
+    auto output = jam::TemporaryFile{};
+    auto in_fd = ::open(input.c_str(), O_RDONLY);
+    auto out_fd = ::open(output.path().c_str(), O_WRONLY | O_TRUNC);
+    REQUIRE( in_fd != -1 );
+    REQUIRE( out_fd != -1 );
+    REQUIRE( jam::copy_fd(in_fd, out_fd, method) == content.size() );
+    ::close(in_fd);
+    ::close(out_fd);
+    REQUIRE( read_file(output.path()) == content );
+
+    in_fd = ::open(input.c_str(), O_RDONLY);
+    out_fd = ::open(output.path().c_str(), O_WRONLY | O_TRUNC);
+    REQUIRE( ::write(out_fd, "head", 4) == 4 );
+    REQUIRE( ::lseek(in_fd, 1000, SEEK_SET) == 1000 );
+    REQUIRE( jam::copy_fd(in_fd, out_fd, method) == content.size() - 1000 );
+    ::close(in_fd);
+    ::close(out_fd);
+    REQUIRE( read_file(output.path()) == "head" + content.substr(1000) );
+}
+} // namespace
+
+
+TEST_CASE( "copy_fd copies files with every method" )
+{
+    const auto content = make_content( (std::size_t{3} << 20) + 123 );
+    auto input = jam::TemporaryFile{};
+    std::ofstream{input.path(), std::ios::binary} << content;
+
+    SECTION( "copy_file_range" ){
+        check_copy( jam::CopyMethod::copy_file_range, input.path(), content );
+    }
+    SECTION( "splice" ){
+        check_copy( jam::CopyMethod::splice, input.path(), content );
+    }
+    SECTION( "sendfile" ){
+        check_copy( jam::CopyMethod::sendfile, input.path(), content );
+    }
+    SECTION( "read/write" ){
+        check_copy( jam::CopyMethod::read_write, input.path(), content );
+    }
+}
+
+TEST_CASE( "copy_fd writes into pipes" )
+{
+    const auto content = make_content( std::size_t{1} << 20 );
+    auto input = jam::TemporaryFile{};
+    std::ofstream{input.path(), std::ios::binary} << content;
+
+    int fds[2];
+    REQUIRE( ::pipe(fds) == 0 );
+    auto received = std::string{};
+    auto reader = std::thread{ [&]{
+        char buffer[4096];
+        for( ssize_t n; (n = ::read(fds[0], buffer, sizeof buffer)) > 0; ){
+            received.append(buffer, static_cast<std::size_t>(n));
+        }
+    }};
+    const auto in_fd = ::open(input.path().c_str(), O_RDONLY);
+    REQUIRE( jam::copy_fd(in_fd, fds[1]) == content.size() );
+    ::close(in_fd);
+    ::close(fds[1]);
+    reader.join();
+    ::close(fds[0]);
+    REQUIRE( received == content );
+}
@@ -0,0 +1,61 @@
+#include "catch/catch.hpp"
+#include "jam/file_prefetch.hpp"
+#include "jam/external_sort.hpp"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cerrno>
+
+#include <unistd.h>
+
+namespace
+{
+auto read_fd( int fd ) -> std::string
+{
+    auto content = std::string{};
+    char buffer[4096];
+    for( ssize_t n; (n = ::read(fd, buffer, sizeof(buffer))) > 0; ){
+        content.append(buffer, static_cast<std::size_t>(n));
+    }
+    return content;
+}
+} // namespace
+
+
+TEST_CASE( "FilePrefetcher hands out the files in order" )
+{
+    auto temporaries = std::vector<std::unique_ptr<jam::TemporaryFile>>{};
+    auto names = std::vector<std::string>{};
+    for( std::size_t i = 0; i != 20; ++i ){
+        temporaries.push_back( std::make_unique<jam::TemporaryFile>() );
+        auto ofs = std::ofstream{ temporaries.back()->path() };
+        ofs << "file " << i << '\n';
+        names.push_back( temporaries.back()->path() );
+    }
+    names.insert( names.begin() + 7, "/nonexistent/jam/prefetch" );
+
+    for( const std::size_t depth : { 0, 1, 3, 50 } ){
+        auto files = jam::FilePrefetcher{ names, depth };
+        auto index = std::size_t{0};
+        for( auto file = jam::PrefetchedFile{}; files.next(file); ++index ){
+            REQUIRE( file.name() == names[index] );
+            if( index == 7 ){
+                REQUIRE( file.fd() == -1 );
+                REQUIRE( file.error() == ENOENT );
+            }
+            else{
+                const auto i = index < 7 ? index : index - 1;
+                REQUIRE( read_fd(file.fd()) == "file " + std::to_string(i) + '\n' );
+            }
+        }
+        REQUIRE( index == names.size() );
+    }
+
+    SECTION( "stopping early" ){
+        auto files = jam::FilePrefetcher{ names, 2 };
+        auto file = jam::PrefetchedFile{};
+        REQUIRE( files.next(file) );
+        REQUIRE( file.name() == names.front() );
+    }
+}
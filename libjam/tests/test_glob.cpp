@@ -0,0 +1,64 @@
+#include "catch/catch.hpp"
+#include "jam/glob.hpp"
+#include <string>
+#include <vector>
+#include <random>
+
+#include <fnmatch.h>
+
+TEST_CASE( "Glob matches shell patterns" )
+{
+    REQUIRE( jam::Glob{"*.txt"}("notes.txt") );
+    REQUIRE( jam::Glob{"*.txt"}(".txt") );
+    REQUIRE_FALSE( jam::Glob{"*.txt"}("notes.txt~") );
+    REQUIRE( jam::Glob{"main.*"}("main.cpp") );
+    REQUIRE( jam::Glob{"*test*"}("my_test_file") );
+    REQUIRE( jam::Glob{"exact"}("exact") );
+    REQUIRE_FALSE( jam::Glob{"exact"}("exactly") );
+    REQUIRE( jam::Glob{"?a*b?c*"}("xaYYbzc") );
+    REQUIRE( jam::Glob{"[a-c]*[!0-9]"}("bxy") );
+    REQUIRE_FALSE( jam::Glob{"[a-c]*[!0-9]"}("bx9") );
+    REQUIRE( jam::Glob{"a*b*a"}("abba") );
+    REQUIRE_FALSE( jam::Glob{"a*b*a"}("aba_") );
+    REQUIRE( jam::Glob{"\\*"}("*") );
+    REQUIRE_FALSE( jam::Glob{"\\*"}("x") );
+    REQUIRE( jam::Glob{"[]x]"}("]") );
+    REQUIRE( jam::Glob{"a["}("a[") );
+    REQUIRE( jam::Glob{""}("") );
+    REQUIRE_FALSE( jam::Glob{""}("a") );
+    REQUIRE( jam::Glob{"*"}("") );
+
+    SECTION( "ignoring case" ){
+        REQUIRE( jam::Glob{"*.TXT", true}("notes.txt") );
+        REQUIRE( jam::Glob{"Read*", true}("README") );
+        REQUIRE( jam::Glob{"[a-c]?", true}("Bz") );
+        REQUIRE( jam::Glob{"*o*", true}("FOO") );
+        REQUIRE_FALSE( jam::Glob{"*.TXT"}("notes.txt") );
+    }
+}
+
+TEST_CASE( "Glob agrees with fnmatch" )
+{
+    const auto patterns = std::vector<std::string>{
+        "*", "?", "a*", "*a", "*a*", "a*b", "*ab*ba*", "a?b*", "[ab]*", "*[!a]",
+        "[a-b]?*b", "??", "*?*?", "b*a*b", "[^b]a*", "*.[ab]", "A*b", "*[A-B]*",
+        "a*a*a*a", "\\a*", "[\\]a]*", "ab", ""
+    };
+    auto generator = std::mt19937{7};
+    auto letter = std::uniform_int_distribution<int>(0, 5);
+    auto length = std::uniform_int_distribution<int>(0, 8);
+    const char letters[] = "abAB.]";
+
+    for( int i = 0; i != 3000; ++i ){
+        auto name = std::string{};
+        for( auto n = length(generator); n != 0; --n ){
+            name += letters[letter(generator)];
+        }
+        for( const auto& pattern : patterns ){
+            INFO( "pattern '" << pattern << "' name '" << name << "'" );
+            REQUIRE( jam::Glob{pattern}(name) == (::fnmatch(pattern.c_str(), name.c_str(), 0) == 0) );
+            REQUIRE( jam::Glob{pattern, true}(name)
+                     == (::fnmatch(pattern.c_str(), name.c_str(), FNM_CASEFOLD) == 0) );
+        }
+    }
+}
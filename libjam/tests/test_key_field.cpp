@@ -0,0 +1,97 @@
+#include "catch/catch.hpp"
+#include "jam/key_field.hpp"
+#include "jam/line_buffer.hpp"
+#include "jam/jam.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+
+
+TEST_CASE( "KeyField selects fields split by a separator" )
+{
+    const auto line = std::string_view{"alpha\tbeta\t\tdelta"};
+
+    REQUIRE( jam::KeyField("2", '\t')(line) == "beta\t\tdelta" );
+    REQUIRE( jam::KeyField("2,2", '\t')(line) == "beta" );
+    REQUIRE( jam::KeyField("3,3", '\t')(line) == "" );
+    REQUIRE( jam::KeyField("4,4", '\t')(line) == "delta" );
+    REQUIRE( jam::KeyField("5,5", '\t')(line) == "" );
+    REQUIRE( jam::KeyField("1.2,1.3", '\t')(line) == "lp" );
+    REQUIRE( jam::KeyField("2.3,4.0", '\t')(line) == "ta\t\tdelta" );
+    REQUIRE( jam::KeyField("1.9,1", '\t')(line) == "" );
+    REQUIRE( jam::KeyField("2,1", '\t')(line) == "" );
+}
+
+TEST_CASE( "KeyField without a separator splits on blanks" )
+{
+    const auto line = std::string_view{"  one two\t three"};
+
+    // Every field keeps the blanks in front of it
+    REQUIRE( jam::KeyField("1,1")(line) == "  one" );
+    REQUIRE( jam::KeyField("2,2")(line) == " two" );
+    REQUIRE( jam::KeyField("3")(line) == "\t three" );
+    REQUIRE( jam::KeyField("2.2,2.3")(line) == "tw" );
+}
+
+TEST_CASE( "KeyField character offsets run past the end of their field" )
+{
+    REQUIRE( jam::KeyField("1.4,1.6")("ab cdX") == "cdX" );
+    REQUIRE( jam::KeyField("1.4,1.6")("zz") == "" );
+    REQUIRE( jam::KeyField("1.3,1.5", '\t')("ab\tcd") == "\tcd" );
+    REQUIRE( jam::KeyField("1.3,1.9", '\t')("ab\tcd") == "\tcd" );
+
+    auto lines = std::vector<std::string>{ "ab cdX", "ab cdA", "zz" };
+    jam::sort_lines_by_key( lines, jam::wrap_binary_predicate(
+                                std::less<std::string_view>(), jam::KeyField("1.4,1.6") ) );
+    REQUIRE( lines == std::vector<std::string>{ "zz", "ab cdA", "ab cdX" } );
+}
+
+TEST_CASE( "KeyField rejects malformed definitions" )
+{
+    REQUIRE_THROWS_AS( jam::KeyField(""), std::invalid_argument );
+    REQUIRE_THROWS_AS( jam::KeyField("0"), std::invalid_argument );
+    REQUIRE_THROWS_AS( jam::KeyField("1.0"), std::invalid_argument );
+    REQUIRE_THROWS_AS( jam::KeyField("x"), std::invalid_argument );
+    REQUIRE_THROWS_AS( jam::KeyField("1,"), std::invalid_argument );
+    REQUIRE_THROWS_AS( jam::KeyField("2n"), std::invalid_argument );
+}
+
+TEST_CASE( "sorting on a key field" )
+{
+    const auto input = std::vector<std::string>{
+        "x\t3\tcarrot", "y\t1\tApple", "z\t2\tbanana", "w\t4\tapple" };
+    const auto expected = std::vector<std::string>{
+        "y\t1\tApple", "w\t4\tapple", "z\t2\tbanana", "x\t3\tcarrot" };
+
+    SECTION( "std::string lines" ){
+        auto lines = input;
+        jam::sort_lines_by_key( lines, jam::wrap_binary_predicate(
+                                    std::less<std::string_view>(), jam::KeyField("3,3", '\t') ) );
+        REQUIRE( lines == expected );
+    }
+
+    SECTION( "reversed, in a LineBuffer" ){
+        auto lines = jam::LineBuffer{};
+        for( const auto& line : input ){
+            lines.push_back(line);
+        }
+        jam::sort_lines_by_key( lines, jam::wrap_binary_predicate(
+                                    std::greater<std::string_view>(), jam::KeyField("2,2", '\t') ) );
+        REQUIRE( lines[0] == "w\t4\tapple" );
+        REQUIRE( lines[3] == "y\t1\tApple" );
+    }
+
+    SECTION( "character-level transforms on top of the key" ){
+        auto lines = input;
+        auto predicate = jam::wrap_binary_predicate( std::less<std::string_view>(),
+                                                     jam::fold_case, jam::KeyField("3,3", '\t') );
+        jam::sort_lines_by_key( lines, predicate );
+        REQUIRE( jam::KeyField("3,3", '\t')(lines[0]) != "banana" );
+        REQUIRE( lines[2] == "z\t2\tbanana" );
+        REQUIRE( lines[3] == "x\t3\tcarrot" );
+        REQUIRE_FALSE( predicate( lines[0], lines[1] ) );
+        REQUIRE_FALSE( predicate( lines[1], lines[0] ) );
+    }
+}
@@ -0,0 +1,98 @@
+#include "catch/catch.hpp"
+#include "jam/line_buffer.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <cctype>
+
+using std::vector;
+using std::string;
+using std::string_view;
+
+TEST_CASE( "LineBuffer stores lines", "[LineBuffer]" )
+{
+    auto lines = jam::LineBuffer{};
+    REQUIRE( lines.empty() );
+
+    SECTION( "lines are copied into the buffer" ){
+        auto line = string{"delta"};
+        lines.emplace_back(line);
+        line = "changed";
+        lines.emplace_back("");
+        REQUIRE( lines.size() == 2 );
+        REQUIRE( lines[0] == "delta" );
+        REQUIRE( lines[1].empty() );
+        REQUIRE( lines.bytes() == 5 );
+    }
+
+    SECTION( "lines longer than a chunk" ){
+        const auto long_line = string(jam::LineBuffer::chunk_size + 10, 'x');
+        lines.emplace_back("short");
+        lines.emplace_back(long_line);
+        lines.emplace_back("after");
+        REQUIRE( lines[0] == "short" );
+        REQUIRE( lines[1] == long_line );
+        REQUIRE( lines[2] == "after" );
+    }
+
+    SECTION( "filled by get_lines" ){
+        auto is = std::istringstream{"delta\nalpha\ncharlie\nbravo\n"};
+        jam::get_lines(is, lines);
+        REQUIRE( vector<string_view>(lines.begin(), lines.end())
+                    == vector<string_view>{"delta", "alpha", "charlie", "bravo"} );
+
+        auto os = std::ostringstream{};
+        os << lines;
+        REQUIRE( os.str() == "delta\nalpha\ncharlie\nbravo\n" );
+    }
+}
+
+TEST_CASE( "sort_lines on a LineBuffer", "[LineBuffer]" )
+{
+    const auto input = vector<string>{"delta", "  Alpha", "charlie", " bravo", "", "Echo", "alpha"};
+    auto lines = jam::LineBuffer{};
+    for( const auto& line : input ){
+        lines.emplace_back(line);
+    }
+    const auto first_line = lines[0].data();
+    auto sorted = [&](){ return vector<string>(lines.begin(), lines.end()); };
+
+    SECTION( "plain orderings only move index entries" ){
+        auto expected = input;
+        std::sort(expected.begin(), expected.end());
+        jam::sort_lines(lines, std::less<string>());
+        REQUIRE( sorted() == expected );
+        REQUIRE( std::any_of(lines.begin(), lines.end(),
+                    [&](string_view line){ return line.data() == first_line; }) );
+
+        std::sort(expected.begin(), expected.end(), std::greater<string>());
+        jam::sort_lines(lines, std::greater<string>(), 2);
+        REQUIRE( sorted() == expected );
+    }
+
+    SECTION( "custom view predicates" ){
+        jam::sort_lines(lines, []( string_view lhs, string_view rhs ){
+            return lhs.size() < rhs.size();
+        });
+        REQUIRE( std::is_sorted(lines.begin(), lines.end(),
+            []( string_view lhs, string_view rhs ){ return lhs.size() < rhs.size(); }) );
+    }
+
+    SECTION( "wrapped predicates sort on precomputed keys" ){
+        auto to_upper = []( const string& s ){
+            auto result = s;
+            std::transform(result.begin(), result.end(), result.begin(),
+                           [](unsigned char ch){ return std::toupper(ch); });
+            return result;
+        };
+        jam::sort_lines(lines, jam::wrap_binary_predicate(std::less<string>(), to_upper));
+        REQUIRE( std::is_sorted(lines.begin(), lines.end(),
+            [&]( string_view lhs, string_view rhs ){
+                return to_upper(string{lhs}) < to_upper(string{rhs});
+            }) );
+        REQUIRE( lines.size() == input.size() );
+    }
+}
@@ -0,0 +1,96 @@
+#include "catch/catch.hpp"
+#include "jam/line_numberer.hpp"
+#include "jam/external_sort.hpp"
+#include "read_file.hpp"
+#include <fstream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+// What cat -n / -b printed with its character loop
+auto reference( const std::vector<std::string>& inputs, jam::LineNumberer::Mode mode,
+                std::size_t number = 1 ) -> std::string
+{
+    auto out = std::string{};
+    for( const auto& input : inputs ){
+        auto line_begin = true;
+        for( const auto ch : input ){
+            if( line_begin && (mode == jam::LineNumberer::Mode::all || ch != '\n') ){
+                out += std::to_string(number++) + ".\t";
+            }
+            line_begin = false;
+            out += ch;
+            if( ch == '\n' ){
+                line_begin = true;
+            }
+        }
+    }
+    return out;
+}
+
+auto number_files( const std::vector<std::string>& inputs, jam::LineNumberer::Mode mode,
+                   std::size_t first = 1, std::size_t block_size = 64 ) -> std::string
+{
+    auto output = jam::TemporaryFile{};
+    const auto out_fd = ::open(output.path().c_str(), O_WRONLY | O_TRUNC);
+    REQUIRE( out_fd != -1 );
+    auto numberer = jam::LineNumberer{ out_fd, mode, first, block_size };
+    for( const auto& content : inputs ){
+        auto input = jam::TemporaryFile{};
+        {
+            auto ofs = std::ofstream{input.path(), std::ios::binary};
+            ofs << content;
+        }
+        const auto in_fd = ::open(input.path().c_str(), O_RDONLY);
+        REQUIRE( in_fd != -1 );
+        numberer.number(in_fd);
+        ::close(in_fd);
+    }
+    ::close(out_fd);
+    return read_file(output.path());
+}
+} // namespace
+
+
+TEST_CASE( "LineNumberer numbers lines like cat" )
+{
+    auto long_lines = std::string{};
+    for( std::size_t i = 0; i != 300; ++i ){
+        long_lines += std::string(i % 150 * 7, 'x') + (i % 7 == 0 ? "\n\n" : "\n");
+    }
+    const auto inputs = std::vector<std::string>{
+        "one\ntwo\n\nfour",
+        "",
+        "\n\nfive\n",
+        long_lines,
+        "last"
+    };
+
+    SECTION( "-n" ){
+        const auto mode = jam::LineNumberer::Mode::all;
+        REQUIRE( number_files(inputs, mode) == reference(inputs, mode) );
+        REQUIRE( number_files(inputs, mode, 1, 1 << 20) == reference(inputs, mode) );
+    }
+    SECTION( "-b" ){
+        const auto mode = jam::LineNumberer::Mode::nonblank;
+        REQUIRE( number_files(inputs, mode) == reference(inputs, mode) );
+        REQUIRE( number_files(inputs, mode, 1, 1 << 20) == reference(inputs, mode) );
+    }
+}
+
+TEST_CASE( "LineNumberer carries the counter over to more digits" )
+{
+    auto input = std::string{};
+    for( std::size_t i = 0; i != 2500; ++i ){
+        input += "l\n";
+    }
+    const auto mode = jam::LineNumberer::Mode::all;
+    REQUIRE( number_files({input}, mode, 95) == reference({input}, mode, 95) );
+    REQUIRE( number_files({input}, mode, 9999990) == reference({input}, mode, 9999990) );
+
+    auto numberer = jam::LineNumberer{ -1, mode, 99 };
+    REQUIRE( numberer.next_number() == 99 );
+}
@@ -0,0 +1,61 @@
+#include "catch/catch.hpp"
+#include "jam/jam.hpp"
+#include "jam/line_reader.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sstream>
+
+using std::vector;
+using std::string;
+
+TEST_CASE( "find_newline", "[LineReader]" )
+{
+    // Long enough for the vector loops and a scalar tail on every offset
+    auto text = string(200, 'x');
+    for( auto position : {0ul, 15ul, 16ul, 31ul, 32ul, 63ul, 64ul, 100ul, 199ul} ){
+        auto s = text;
+        s[position] = '\n';
+        REQUIRE( jam::find_newline(s.data(), s.data() + s.size()) == s.data() + position );
+    }
+    REQUIRE( jam::find_newline(text.data(), text.data() + text.size()) == text.data() + text.size() );
+}
+
+TEST_CASE( "LineReader splits lines", "[LineReader]" )
+{
+    auto read_all = []( const string& input, std::size_t block_size ){
+        auto is = std::istringstream{input};
+        auto reader = jam::LineReader{is, block_size};
+        auto lines = vector<string>{};
+        for( std::string_view line; reader.next(line); ){
+            lines.emplace_back(line);
+        }
+        return lines;
+    };
+
+    SECTION( "same lines as getline" ){
+        const auto input = string{"one\n\nthree\nfour"};
+        auto is = std::istringstream{input};
+        auto expected = vector<string>{};
+        for( string line; getline(is, line); ){
+            expected.push_back(line);
+        }
+        REQUIRE( read_all(input, 64) == expected );
+        REQUIRE( read_all(input + "\n", 64) == expected );
+    }
+
+    SECTION( "lines longer than a block" ){
+        const auto long_line = string(1000, 'a');
+        const auto input = "short\n" + long_line + "\n" + long_line;
+        REQUIRE( read_all(input, 64) == vector<string>{"short", long_line, long_line} );
+    }
+
+    SECTION( "empty input" ){
+        REQUIRE( read_all("", 64).empty() );
+    }
+
+    SECTION( "get_lines goes through the reader" ){
+        auto is = std::istringstream{"b\na\nc\n"};
+        REQUIRE( jam::get_lines<vector<string>>(is) == vector<string>{"b", "a", "c"} );
+    }
+}
@@ -0,0 +1,56 @@
+#include "catch/catch.hpp"
+#include "jam/line_writer.hpp"
+#include "jam/external_sort.hpp"
+#include "read_file.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+
+TEST_CASE( "LineWriter writes lines to a file" )
+{
+    auto file = jam::TemporaryFile{};
+
+    SECTION( "lines smaller and larger than the buffer" ){
+        const auto long_line = std::string(100, 'x');
+        {
+            auto writer = jam::LineWriter{ file.path(), 16 };
+            writer.write_line("one");
+            writer.write_line("");
+            writer.write_line(long_line);
+            writer.write("no newline");
+            writer.write_lines( std::vector<std::string>{"two", "three"} );
+            writer.flush();
+            REQUIRE( writer.bytes_written() == 4 + 1 + 101 + 10 + 4 + 6 );
+        }
+        REQUIRE( read_file(file.path()) == "one\n\n" + long_line + "\nno newlinetwo\nthree\n" );
+    }
+
+    SECTION( "the destructor writes what is left, a moved-from writer nothing" ){
+        {
+            auto writer = jam::LineWriter{ file.path() };
+            writer.write_line("kept");
+            auto other = std::move(writer);
+            other.write_line("too");
+        }
+        REQUIRE( read_file(file.path()) == "kept\ntoo\n" );
+    }
+
+    SECTION( "throughput report" ){
+        auto writer = jam::LineWriter{ file.path() };
+        for( int i = 0; i != 1000; ++i ){
+            writer.write_line("some line");
+        }
+        writer.flush();
+        auto report = std::ostringstream{};
+        writer.report(report);
+        REQUIRE( writer.bytes_written() == 10000 );
+        REQUIRE( report.str().find("10000 bytes") != std::string::npos );
+    }
+}
+
+TEST_CASE( "LineWriter reports files it cannot open" )
+{
+    REQUIRE_THROWS_AS( jam::LineWriter{"/nonexistent/directory/file"}, std::runtime_error );
+}
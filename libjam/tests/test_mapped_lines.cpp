@@ -0,0 +1,99 @@
+#include "catch/catch.hpp"
+#include "jam/jam.hpp"
+#include "jam/mapped_lines.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <cstdio>
+
+using std::vector;
+using std::string_view;
+
+namespace
+{
+const auto test_file = std::string{"test_mapped_lines.txt"};
+
+void write_test_file( const std::string& contents )
+{
+    auto ofs = std::ofstream{test_file, std::ios::binary};
+    ofs << contents;
+}
+} // namespace
+
+
+TEST_CASE( "MappedLines indexes lines", "[MappedLines]" )
+{
+    SECTION( "lines ending with a newline" ){
+        write_test_file("delta\nalpha\n\ncharlie\n");
+        auto mapped = jam::MappedLines{test_file};
+        REQUIRE( mapped.size() == 4 );
+        REQUIRE( mapped[0] == "delta" );
+        REQUIRE( mapped[1] == "alpha" );
+        REQUIRE( mapped[2].empty() );
+        REQUIRE( mapped[3] == "charlie" );
+    }
+
+    SECTION( "last line without a newline" ){
+        write_test_file("delta\nalpha");
+        auto mapped = jam::MappedLines{test_file};
+        REQUIRE( mapped.size() == 2 );
+        REQUIRE( mapped[1] == "alpha" );
+    }
+
+    SECTION( "empty file" ){
+        write_test_file("");
+        auto mapped = jam::MappedLines{test_file};
+        REQUIRE( mapped.empty() );
+        REQUIRE( mapped.begin() == mapped.end() );
+    }
+
+    SECTION( "missing file throws" ){
+        REQUIRE_THROWS( jam::MappedLines{"no_such_file.txt"} );
+        REQUIRE_FALSE( jam::MappedLines::can_map("no_such_file.txt") );
+    }
+
+    SECTION( "files without a size are refused" ){
+        // Regular, but its size says nothing about its contents
+        REQUIRE_FALSE( jam::MappedLines::can_map("/proc/self/status") );
+        REQUIRE_THROWS_AS( jam::MappedLines{"/proc/self/status"}, std::runtime_error );
+        REQUIRE_FALSE( jam::MappedLines::can_map(".") );
+        REQUIRE_THROWS_AS( jam::MappedLines{"."}, std::runtime_error );
+        write_test_file("alpha\n");
+        REQUIRE( jam::MappedLines::can_map(test_file) );
+    }
+    std::remove(test_file.c_str());
+}
+
+TEST_CASE( "get_lines from MappedLines", "[MappedLines]" )
+{
+    write_test_file("delta\nalpha\nbravo\ncharlie\n");
+    auto mapped = jam::MappedLines{test_file};
+
+    SECTION( "views point into the mapping" ){
+        auto lines = jam::get_lines<vector<string_view>>(mapped);
+        REQUIRE( lines.size() == 4 );
+        REQUIRE( lines[0].data() == mapped.view().data() );
+    }
+
+    SECTION( "views can be sorted without copying" ){
+        auto lines = jam::get_lines<vector<string_view>>(mapped);
+        jam::sort_lines(lines, std::less<>());
+        REQUIRE( lines == vector<string_view>{"alpha", "bravo", "charlie", "delta"} );
+    }
+
+    SECTION( "filter based on predicate" ){
+        auto lines = jam::get_lines<vector<string_view>>(mapped,
+                        [](string_view line){ return line.size() == 5; });
+        REQUIRE( lines == vector<string_view>{"delta", "alpha", "bravo"} );
+    }
+
+    SECTION( "moved-from mapping is empty" ){
+        auto other = std::move(mapped);
+        REQUIRE( other.size() == 4 );
+        REQUIRE( mapped.empty() );
+    }
+    std::remove(test_file.c_str());
+}
@@ -0,0 +1,40 @@
+#include "catch/catch.hpp"
+#include "jam/mpsc_queue.hpp"
+#include <thread>
+#include <vector>
+#include <utility>
+
+TEST_CASE( "MpscQueue keeps the order of every producer" )
+{
+    constexpr int producers = 4;
+    constexpr int values = 20000;
+
+    auto queue = jam::MpscQueue<std::pair<int, int>>{};
+    REQUIRE( queue.empty() );
+
+    auto threads = std::vector<std::thread>{};
+    for( int producer = 0; producer != producers; ++producer ){
+        threads.emplace_back( [&queue, producer]{
+            for( int i = 0; i != values; ++i ){
+                queue.push( {producer, i} );
+            }
+        });
+    }
+
+    auto next = std::vector<int>(producers, 0);
+    auto received = 0;
+    const auto check = [&]( std::pair<int, int> value ){
+        REQUIRE( value.second == next[value.first] );
+        ++next[value.first];
+        ++received;
+    };
+    while( received != producers * values ){
+        queue.consume(check);
+    }
+    for( auto& thread : threads ){
+        thread.join();
+    }
+
+    REQUIRE( queue.empty() );
+    REQUIRE( queue.consume(check) == 0 );
+}
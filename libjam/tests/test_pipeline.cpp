@@ -0,0 +1,133 @@
+#include "catch/catch.hpp"
+#include "jam/pipeline.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+#include <cctype>
+
+namespace
+{
+auto numbered_lines( std::size_t count ) -> std::string
+{
+    auto text = std::string{};
+    for( std::size_t i = 0; i != count; ++i ){
+        text += "line " + std::to_string(i) + '\n';
+    }
+    return text;
+}
+} // namespace
+
+
+TEST_CASE( "BoundedQueue hands values over between threads" )
+{
+    auto queue = jam::BoundedQueue<int>{2};
+    auto producer = std::thread{ [&]{
+        for( int i = 0; i != 1000; ++i ){
+            queue.push(i);
+        }
+        queue.close();
+    }};
+    auto received = std::vector<int>{};
+    for( int value; queue.pop(value); ){
+        received.push_back(value);
+    }
+    producer.join();
+
+    REQUIRE( received.size() == 1000 );
+    for( int i = 0; i != 1000; ++i ){
+        REQUIRE( received[i] == i );
+    }
+    REQUIRE_FALSE( queue.push(1000) );
+}
+
+TEST_CASE( "Pipeline streams lines through its stages in order" )
+{
+    auto input = std::istringstream{ numbered_lines(10000) };
+    auto output = std::ostringstream{};
+
+    auto pipeline = jam::Pipeline{ 2, 64 };
+    pipeline.filter( []( const std::string& line ){ return line.back() != '7'; }, "no sevens" )
+            .transform( []( std::string line ){
+                for( auto& ch : line ){
+                    ch = static_cast<char>( std::toupper(static_cast<unsigned char>(ch)) );
+                }
+                return line;
+            }, "upper" );
+
+    SECTION( "all stages" ){
+        pipeline.run( input, output );
+
+        auto expected = std::string{};
+        for( std::size_t i = 0; i != 10000; ++i ){
+            if( i % 10 != 7 ){
+                expected += "LINE " + std::to_string(i) + '\n';
+            }
+        }
+        REQUIRE( output.str() == expected );
+
+        const auto& stats = pipeline.stats();
+        REQUIRE( stats.size() == 4 );
+        REQUIRE( stats[0]->name == "read" );
+        REQUIRE( stats[0]->lines_out == 10000 );
+        REQUIRE( stats[1]->name == "no sevens" );
+        REQUIRE( stats[1]->lines_in == 10000 );
+        REQUIRE( stats[1]->lines_out == 9000 );
+        REQUIRE( stats[2]->lines_out == 9000 );
+        REQUIRE( stats[3]->name == "write" );
+        REQUIRE( stats[3]->bytes_out == expected.size() );
+    }
+
+    SECTION( "the reader stage filters like get_lines" ){
+        pipeline.run( input, output, []( const std::string& line ){ return line.back() == '1'; } );
+
+        auto expected = std::string{};
+        for( std::size_t i = 1; i < 10000; i += 10 ){
+            expected += "LINE " + std::to_string(i) + '\n';
+        }
+        REQUIRE( output.str() == expected );
+        REQUIRE( pipeline.stats()[0]->lines_in == 10000 );
+        REQUIRE( pipeline.stats()[0]->lines_out == 1000 );
+    }
+}
+
+TEST_CASE( "Pipeline rewrites only the lines it keeps" )
+{
+    auto input = std::istringstream{ numbered_lines(1000) };
+    auto output = std::ostringstream{};
+
+    auto pipeline = jam::Pipeline{ 2, 64 };
+    pipeline.filter_transform( [n = std::size_t{0}]( std::string& line ) mutable {
+        if( ++n % 100 != 0 ){
+            return false;
+        }
+        line.insert( 0, std::to_string(n) + ": " );
+        return true;
+    }, "number" );
+    pipeline.run( input, output );
+
+    auto expected = std::string{};
+    for( std::size_t i = 99; i < 1000; i += 100 ){
+        expected += std::to_string(i + 1) + ": line " + std::to_string(i) + '\n';
+    }
+    REQUIRE( output.str() == expected );
+    REQUIRE( pipeline.stats()[1]->lines_in == 1000 );
+    REQUIRE( pipeline.stats()[1]->lines_out == 10 );
+}
+
+TEST_CASE( "Pipeline reports the errors of its stages" )
+{
+    auto input = std::istringstream{ numbered_lines(100000) };
+    auto output = std::ostringstream{};
+
+    auto pipeline = jam::Pipeline{ 1, 16 };
+    pipeline.transform( []( const std::string& line ) -> std::string {
+        if( line == "line 5000" ){
+            throw std::runtime_error( "bad line" );
+        }
+        return line;
+    });
+
+    REQUIRE_THROWS_WITH( pipeline.run(input, output), "bad line" );
+}
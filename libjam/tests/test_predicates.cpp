@@ -4,6 +4,11 @@
 #include <algorithm>
 #include <vector>
 #include <iterator>
+#include <list>
+#include <string>
+#include <utility>
+#include <type_traits>
+#include <cctype>
 
 #include <iostream>
 
@@ -45,4 +50,148 @@ TEST_CASE( "transform_iterator" )
                  );
         REQUIRE( result == expected );
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE( "transform_iterator follows the base iterator category" )
+{
+    auto test_input = std::vector<std::string>{"delta", "alpha", "charlie", "bravo"};
+    std::sort(test_input.begin(), test_input.end());
+    auto length = [](const std::string& s){ return s.size(); };
+    using Iterator = decltype(jam::make_transform_iterator(test_input.cbegin(), length));
+    static_assert( std::is_same_v<std::iterator_traits<Iterator>::iterator_category,
+                                  std::random_access_iterator_tag> );
+
+    auto first = jam::make_transform_iterator(test_input.cbegin(), length);
+    auto last = jam::make_transform_iterator(test_input.cend(), length);
+    REQUIRE( last - first == 4 );
+    REQUIRE( first[2] == 7 );
+    REQUIRE( *(first + 3) == 5 );
+
+    SECTION( "std::lower_bound over a projection" ){
+        auto first_letter = [](const std::string& s){ return s.front(); };
+        auto it = std::lower_bound(jam::make_transform_iterator(test_input.cbegin(), first_letter),
+                                   jam::make_transform_iterator(test_input.cend(), first_letter),
+                                   'c');
+        REQUIRE( *it.base() == "charlie" );
+    }
+
+    SECTION( "std::sort through a projection returning references" ){
+        auto values = std::vector<std::pair<int,int>>{{3,0}, {1,1}, {2,2}};
+        auto second = [](std::pair<int,int>& p) -> int& { return p.second; };
+        std::sort(jam::make_transform_iterator(values.begin(), second),
+                  jam::make_transform_iterator(values.end(), second),
+                  std::greater<int>());
+        REQUIRE( values == std::vector<std::pair<int,int>>{{3,2}, {1,1}, {2,0}} );
+    }
+
+    SECTION( "list iterators stay bidirectional" ){
+        auto test_list = std::list<std::string>(test_input.cbegin(), test_input.cend());
+        using ListIterator = decltype(jam::make_transform_iterator(test_list.cbegin(), length));
+        static_assert( std::is_same_v<std::iterator_traits<ListIterator>::iterator_category,
+                                      std::bidirectional_iterator_tag> );
+    }
+}
+
+TEST_CASE( "caching_transform_iterator" )
+{
+    auto test_input = std::vector<int>{1,2,3,4,5,6,7,8,9,10};
+    auto calls = 0;
+    auto square = [&calls](int i){ ++calls; return std::to_string(i * i); };
+
+    auto it = jam::make_caching_transform_iterator(test_input.cbegin(), square);
+    REQUIRE( *it == "1" );
+    REQUIRE( it->size() == 1 );
+    REQUIRE( *it == "1" );
+    REQUIRE( calls == 1 );
+    ++it;
+    REQUIRE( *it == "4" );
+    REQUIRE( calls == 2 );
+
+    SECTION( "an input iterator, whatever the base" ){
+        using CachingIterator = decltype(it);
+        static_assert( std::is_same_v<std::iterator_traits<CachingIterator>::iterator_category,
+                                      std::input_iterator_tag> );
+    }
+
+    SECTION( "usable with std::copy_if, one call per element" ){
+        auto identity = [&calls](int i){ ++calls; return i; };
+        calls = 0;
+        auto even = std::vector<int>{};
+        std::copy_if(jam::make_caching_transform_iterator(test_input.cbegin(), identity),
+                     jam::make_caching_transform_iterator(test_input.cend(), identity),
+                     std::back_inserter(even),
+                     [](int i){ return i % 2 == 0; });
+        REQUIRE( even == std::vector<int>{2,4,6,8,10} );
+        REQUIRE( calls == 10 );
+    }
+}
+
+TEST_CASE( "character-level transforms fuse into one comparison" )
+{
+    auto eager_upper = []( const std::string& s ){
+        auto result = s;
+        std::transform( result.begin(), result.end(), result.begin(),
+                        []( unsigned char ch ){ return static_cast<char>(std::toupper(ch)); } );
+        return result;
+    };
+
+    SECTION( "called on a line, the transforms return the transformed copy" ){
+        REQUIRE( jam::fold_case("abc-Def 1") == "ABC-DEF 1" );
+        REQUIRE( jam::skip_leading_blanks(" \t  abc ") == "abc " );
+        REQUIRE( jam::skip_leading_blanks("   ") == "" );
+        REQUIRE( jam::dictionary_order("a-b, c!9") == "ab c9" );
+    }
+
+    SECTION( "chains of character-level transforms are fused" ){
+        using Fused = decltype( jam::wrap_binary_predicate( std::less<std::string>(),
+                                    jam::fold_case, jam::skip_leading_blanks ) );
+        using Mixed = decltype( jam::wrap_binary_predicate( std::less<std::string>(),
+                                    jam::fold_case, eager_upper ) );
+        REQUIRE( jam::detail::is_fused_v<Fused> );
+        REQUIRE_FALSE( jam::detail::is_fused_v<Mixed> );
+    }
+
+    SECTION( "the fused comparison agrees with the eager one" ){
+        auto input = vector<std::string>{ "  beta", "Alpha", "alpha!", "", " ", "\tgamma",
+                                          "a-b", "ab", "AB", "zeta", "Zeta", "b", "  a b" };
+        auto fused = jam::wrap_binary_predicate( std::less<std::string>(),
+                                                 jam::fold_case, jam::dictionary_order,
+                                                 jam::skip_leading_blanks );
+        auto eager = [&]( const std::string& lhs, const std::string& rhs ){
+            return jam::fold_case(jam::dictionary_order(jam::skip_leading_blanks(lhs)))
+                 < jam::fold_case(jam::dictionary_order(jam::skip_leading_blanks(rhs)));
+        };
+        for( auto& lhs : input ){
+            for( auto& rhs : input ){
+                REQUIRE( fused(lhs, rhs) == eager(lhs, rhs) );
+            }
+        }
+    }
+
+    SECTION( "the order of application is kept" ){
+        // Blanks skipped before dictionary filtering vs. after it
+        auto blanks_first = jam::wrap_binary_predicate( std::less<std::string>(),
+                                jam::dictionary_order, jam::skip_leading_blanks );
+        auto blanks_last = jam::wrap_binary_predicate( std::less<std::string>(),
+                                jam::skip_leading_blanks, jam::dictionary_order );
+        auto lhs = std::string{"- b"};
+        auto rhs = std::string{"a"};
+        REQUIRE( blanks_first(lhs, rhs) );
+        REQUIRE_FALSE( blanks_last(lhs, rhs) );
+    }
+
+    SECTION( "reversed orders and keyed sorts" ){
+        auto input = vector<std::string>{ "b", " A", "c", "  a", "B" };
+        auto lines = input;
+        jam::sort_lines_by_key( lines, jam::wrap_binary_predicate( std::greater<std::string>(),
+                                           jam::fold_case, jam::skip_leading_blanks ) );
+        std::stable_sort( input.begin(), input.end(), [&]( const std::string& lhs, const std::string& rhs ){
+            return eager_upper(jam::skip_leading_blanks(lhs)) > eager_upper(jam::skip_leading_blanks(rhs));
+        });
+        REQUIRE( lines.size() == input.size() );
+        for( std::size_t i = 0; i != lines.size(); ++i ){
+            REQUIRE( eager_upper(jam::skip_leading_blanks(lines[i]))
+                     == eager_upper(jam::skip_leading_blanks(input[i])) );
+        }
+    }
+}
@@ -3,6 +3,11 @@
 #include <vector>
 #include <list>
 #include <functional>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cctype>
+#include <string_view>
 
 using std::vector;
 using std::list;
@@ -33,3 +38,168 @@ TEST_CASE( "sort_lines", "[sort]" )
 
     
 }
+
+TEST_CASE( "parallel sort_lines", "[sort]" )
+{
+    auto test_vector = vector<std::string>{};
+    auto generator = std::mt19937{42};
+    auto letter = std::uniform_int_distribution<int>('a', 'z');
+    auto length = std::uniform_int_distribution<std::size_t>(0, 12);
+    for( auto i = 0; i != 100000; ++i ){
+        auto line = std::string(length(generator), ' ');
+        for( auto& ch : line ){
+            ch = static_cast<char>(letter(generator));
+        }
+        test_vector.push_back(std::move(line));
+    }
+
+    SECTION( "vectors are sorted with multiple threads" )
+    {
+        auto expected = test_vector;
+        std::sort(expected.begin(), expected.end());
+        jam::sort_lines(test_vector, std::less<std::string>(), 4);
+        REQUIRE( test_vector == expected );
+    }
+
+    SECTION( "thread count of 0 uses the hardware concurrency" )
+    {
+        auto expected = test_vector;
+        std::sort(expected.begin(), expected.end(), std::greater<std::string>());
+        jam::sort_lines(test_vector, std::greater<std::string>(), 0);
+        REQUIRE( test_vector == expected );
+    }
+
+    SECTION( "wrapped binary predicates are supported" )
+    {
+        auto to_upper = []( const std::string& s ){
+            auto result = s;
+            std::transform(result.begin(), result.end(), result.begin(),
+                           [](unsigned char ch){ return std::toupper(ch); });
+            return result;
+        };
+        auto predicate = jam::wrap_binary_predicate(std::less<std::string>(), to_upper);
+        jam::sort_lines(test_vector, predicate, 3);
+        REQUIRE( std::is_sorted(test_vector.cbegin(), test_vector.cend(),
+            [&](const std::string& lhs, const std::string& rhs){
+                return to_upper(lhs) < to_upper(rhs);
+            }) );
+    }
+
+    SECTION( "lists ignore the thread count" )
+    {
+        auto test_list = list<std::string>(test_vector.cbegin(), test_vector.cend());
+        auto expected = test_vector;
+        std::sort(expected.begin(), expected.end());
+        jam::sort_lines(test_list, std::less<std::string>(), 4);
+        REQUIRE( std::equal(test_list.cbegin(), test_list.cend(), expected.cbegin()) );
+    }
+}
+
+TEST_CASE( "sort_lines_by_key", "[sort]" )
+{
+    auto transforms = 0;
+    auto to_upper = [&transforms]( const std::string& s ){
+        ++transforms;
+        auto result = s;
+        std::transform(result.begin(), result.end(), result.begin(),
+                       [](unsigned char ch){ return std::toupper(ch); });
+        return result;
+    };
+    auto ignore_leading_blanks = []( const std::string& s ) -> std::string {
+        const auto sbegin = s.find_first_not_of(" \t");
+        return sbegin == std::string::npos ? "" : s.substr(sbegin);
+    };
+    const auto input = vector<std::string>{"delta", "  Alpha", "charlie", " bravo", "", "Echo"};
+    const auto expected = vector<std::string>{"", "  Alpha", " bravo", "charlie", "delta", "Echo"};
+
+    SECTION( "every line is transformed once" )
+    {
+        auto lines = input;
+        auto predicate = jam::wrap_binary_predicate(
+                std::less<std::string>(), to_upper, ignore_leading_blanks);
+        jam::sort_lines_by_key(lines, predicate);
+        REQUIRE( lines == expected );
+        REQUIRE( transforms == static_cast<int>(input.size()) );
+    }
+
+    SECTION( "lists are reordered by splicing" )
+    {
+        auto lines = list<std::string>(input.cbegin(), input.cend());
+        auto predicate = jam::wrap_binary_predicate(
+                std::greater<std::string>(), to_upper, ignore_leading_blanks);
+        jam::sort_lines_by_key(lines, predicate);
+        REQUIRE( std::equal(lines.cbegin(), lines.cend(), expected.crbegin()) );
+    }
+
+    SECTION( "non-string keys" )
+    {
+        auto lines = input;
+        auto predicate = jam::wrap_binary_predicate(
+                std::less<std::size_t>(), [](const std::string& s){ return s.size(); });
+        jam::sort_lines_by_key(lines, predicate);
+        REQUIRE( std::is_sorted(lines.cbegin(), lines.cend(),
+            [](const std::string& lhs, const std::string& rhs){
+                return lhs.size() < rhs.size();
+            }) );
+    }
+
+    SECTION( "plain predicates are sorted directly" )
+    {
+        auto lines = input;
+        auto sorted = input;
+        std::sort(sorted.begin(), sorted.end());
+        jam::sort_lines_by_key(lines, std::less<std::string>());
+        REQUIRE( lines == sorted );
+    }
+}
+
+TEST_CASE( "sort_lines on plain string orderings", "[sort]" )
+{
+    // Long shared prefixes, empty lines, prefixes of other lines and bytes
+    // above 0x7f - the multikey sort has to agree with std::string::compare
+    auto test_vector = vector<std::string>{};
+    auto generator = std::mt19937{1};
+    auto byte = std::uniform_int_distribution<int>(0, 255);
+    auto length = std::uniform_int_distribution<std::size_t>(0, 6);
+    const auto prefixes = vector<std::string>{"", "2018-07-18 12:00:0", "2018-07-18 12:00:01 ERROR", "a"};
+    for( auto i = 0; i != 20000; ++i ){
+        auto line = prefixes[i % prefixes.size()];
+        for( auto n = length(generator); n != 0; --n ){
+            line += static_cast<char>(byte(generator));
+        }
+        test_vector.push_back(std::move(line));
+    }
+
+    SECTION( "std::less<std::string>" )
+    {
+        auto expected = test_vector;
+        std::sort(expected.begin(), expected.end());
+        jam::sort_lines(test_vector, std::less<std::string>());
+        REQUIRE( test_vector == expected );
+    }
+
+    SECTION( "std::greater<std::string>" )
+    {
+        auto expected = test_vector;
+        std::sort(expected.begin(), expected.end(), std::greater<std::string>());
+        jam::sort_lines(test_vector, std::greater<std::string>());
+        REQUIRE( test_vector == expected );
+    }
+
+    SECTION( "string views with a transparent predicate" )
+    {
+        auto views = vector<std::string_view>(test_vector.cbegin(), test_vector.cend());
+        auto expected = views;
+        std::sort(expected.begin(), expected.end());
+        jam::sort_lines(views, std::less<>());
+        REQUIRE( views == expected );
+    }
+
+    SECTION( "in parallel" )
+    {
+        auto expected = test_vector;
+        std::sort(expected.begin(), expected.end(), std::greater<std::string>());
+        jam::sort_lines(test_vector, std::greater<std::string>(), 4);
+        REQUIRE( test_vector == expected );
+    }
+}
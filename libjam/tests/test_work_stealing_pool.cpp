@@ -0,0 +1,54 @@
+#include "catch/catch.hpp"
+#include "jam/work_stealing_pool.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <functional>
+
+namespace
+{
+// Every call submits its two subtrees, a complete binary tree of tasks
+void spawn( jam::WorkStealingPool& pool, std::atomic<int>& count, int depth )
+{
+    count.fetch_add(1);
+    if( depth == 0 ){
+        return;
+    }
+    pool.submit( [&pool, &count, depth]{ spawn(pool, count, depth - 1); } );
+    pool.submit( [&pool, &count, depth]{ spawn(pool, count, depth - 1); } );
+}
+} // namespace
+
+
+TEST_CASE( "WorkStealingPool runs tasks submitted by tasks" )
+{
+    for( const unsigned threads : { 1u, 2u, 4u } ){
+        auto pool = jam::WorkStealingPool{ threads };
+        REQUIRE( pool.size() == threads );
+        auto count = std::atomic<int>{0};
+        pool.submit( [&]{ spawn(pool, count, 14); } );
+        pool.wait();
+        REQUIRE( count == (1 << 15) - 1 );
+
+        // The pool can be reused after wait()
+        pool.submit( [&]{ spawn(pool, count, 3); } );
+        pool.wait();
+        REQUIRE( count == (1 << 15) - 1 + 15 );
+    }
+}
+
+TEST_CASE( "WorkStealingPool rethrows the first error from wait()" )
+{
+    auto pool = jam::WorkStealingPool{ 3 };
+    auto count = std::atomic<int>{0};
+    for( int i = 0; i != 100; ++i ){
+        pool.submit( [&, i]{
+            count.fetch_add(1);
+            if( i == 42 ){
+                throw std::runtime_error( "task failed" );
+            }
+        });
+    }
+    REQUIRE_THROWS_WITH( pool.wait(), "task failed" );
+    REQUIRE( count == 100 );
+    REQUIRE_NOTHROW( pool.wait() );
+}